@@ -0,0 +1,342 @@
+#pragma once
+
+#include <string_view>
+
+// ----------------------------------------------------------------------
+
+// Compile time matchers for the anchor patterns used by the lab extractors (sheet-extractor.cc),
+// each function accepts exactly what the former case insensitive std::regex (given in the comment) found by std::regex_search.
+// Patterns whose submatches are used (serum names and ids, Crick less-than notes) are still
+// std::regex for extracting fields, their matchers here are used to find rows and columns.
+
+namespace acmacs::sheet::inline v1::anchor
+{
+    namespace detail
+    {
+        constexpr bool is_space(char cc) { return cc == ' ' || cc == '\t' || cc == '\n' || cc == '\v' || cc == '\f' || cc == '\r'; }
+        constexpr bool is_digit(char cc) { return cc >= '0' && cc <= '9'; }
+        constexpr bool is_alpha(char cc) { return (cc >= 'A' && cc <= 'Z') || (cc >= 'a' && cc <= 'z'); }
+        constexpr bool is_word(char cc) { return is_alpha(cc) || is_digit(cc) || cc == '_'; }
+        constexpr bool is_line_terminator(char cc) { return cc == '\n' || cc == '\r'; }
+        constexpr char upper(char cc) { return (cc >= 'a' && cc <= 'z') ? static_cast<char>(cc - 'a' + 'A') : cc; }
+
+        constexpr size_t skip_spaces(std::string_view src, size_t pos)
+        {
+            while (pos < src.size() && is_space(src[pos]))
+                ++pos;
+            return pos;
+        }
+
+        template <typename Pred> constexpr size_t skip(std::string_view src, size_t pos, Pred pred)
+        {
+            while (pos < src.size() && pred(src[pos]))
+                ++pos;
+            return pos;
+        }
+
+        // word is upper case
+        constexpr bool word_at(std::string_view src, size_t pos, std::string_view word)
+        {
+            if (src.size() < pos || (src.size() - pos) < word.size())
+                return false;
+            for (size_t ind{0}; ind < word.size(); ++ind) {
+                if (upper(src[pos + ind]) != word[ind])
+                    return false;
+            }
+            return true;
+        }
+
+        // \b after a word ending with a word char
+        constexpr bool word_end(std::string_view src, size_t pos) { return pos == src.size() || !is_word(src[pos]); }
+
+        constexpr bool label_at(std::string_view src, size_t pos, std::string_view word) { return word_at(src, pos, word) && word_end(src, pos + word.size()); }
+
+        // ^\s*WORD\s*$
+        constexpr bool whole_label(std::string_view src, std::string_view word)
+        {
+            const auto first = skip_spaces(src, 0);
+            return word_at(src, first, word) && skip_spaces(src, first + word.size()) == src.size();
+        }
+
+        template <typename Pred> constexpr bool all_of(std::string_view src, Pred pred)
+        {
+            for (const char cc : src) {
+                if (!pred(cc))
+                    return false;
+            }
+            return true;
+        }
+
+        constexpr bool digits(std::string_view src, size_t number) { return src.size() == number && all_of(src, is_digit); }
+
+    } // namespace detail
+
+    // ----------------------------------------------------------------------
+
+    // ^(MDCK|QMC|C|SIAT|S|E|HCK|CELL|EGG)
+    constexpr bool serum_passage(std::string_view src)
+    {
+        using namespace detail;
+        return (!src.empty() && (upper(src[0]) == 'C' || upper(src[0]) == 'S' || upper(src[0]) == 'E')) || word_at(src, 0, "MDCK") || word_at(src, 0, "QMC") || word_at(src, 0, "HCK");
+    }
+
+    // ----------------------------------------------------------------------
+    // CDC
+
+    // ^[0-9]{10}$
+    constexpr bool CDC_antigen_lab_id(std::string_view src) { return detail::digits(src, 10); }
+
+    // ^([A-Z]|EGG)$   EGG is excel auto-correction artefact
+    constexpr bool CDC_serum_index(std::string_view src) { return (src.size() == 1 && detail::is_alpha(src[0])) || (src.size() == 3 && detail::word_at(src, 0, "EGG")); }
+
+    // ^\s*(BACK)?\s*TITER\b
+    constexpr bool CDC_titer_label(std::string_view src)
+    {
+        using namespace detail;
+        const auto first = skip_spaces(src, 0);
+        return label_at(src, first, "TITER") || (word_at(src, first, "BACK") && label_at(src, skip_spaces(src, first + 4), "TITER"));
+    }
+
+    // ^\s*HA\s*GROUP\b
+    constexpr bool CDC_ha_group_label(std::string_view src)
+    {
+        using namespace detail;
+        const auto first = skip_spaces(src, 0);
+        return word_at(src, first, "HA") && label_at(src, skip_spaces(src, first + 2), "GROUP");
+    }
+
+    // \bCONTROL\b
+    constexpr bool CDC_antigen_control(std::string_view src)
+    {
+        using namespace detail;
+        for (size_t pos{0}; pos < src.size(); ++pos) {
+            if ((pos == 0 || !is_word(src[pos - 1])) && label_at(src, pos, "CONTROL"))
+                return true;
+        }
+        return false;
+    }
+
+    // ----------------------------------------------------------------------
+    // AC21
+
+    // ^[0-9]+$
+    constexpr bool AC21_serum_index(std::string_view src) { return !src.empty() && detail::all_of(src, detail::is_digit); }
+
+    // ----------------------------------------------------------------------
+    // CRICK
+
+    // ^([AB]/[A-Z '_-]+|NYMC\s+X-[0-9]+[A-Z]*)$
+    constexpr bool CRICK_serum_name_1(std::string_view src)
+    {
+        using namespace detail;
+        if (src.size() > 2 && (upper(src[0]) == 'A' || upper(src[0]) == 'B') && src[1] == '/')
+            return all_of(src.substr(2), [](char cc) { return is_alpha(cc) || cc == ' ' || cc == '\'' || cc == '_' || cc == '-'; });
+        if (word_at(src, 0, "NYMC")) {
+            if (const auto x_pos = skip_spaces(src, 4); x_pos > 4 && word_at(src, x_pos, "X-")) {
+                if (const auto digits_end = skip(src, x_pos + 2, is_digit); digits_end > (x_pos + 2))
+                    return skip(src, digits_end, is_alpha) == src.size();
+            }
+        }
+        return false;
+    }
+
+    // ^[A-Z0-9-/]+$
+    constexpr bool CRICK_serum_name_2(std::string_view src)
+    {
+        return !src.empty() && detail::all_of(src, [](char cc) { return detail::is_alpha(cc) || detail::is_digit(cc) || cc == '-' || cc == '/'; });
+    }
+
+    // ^(?:[A-Z\s]+\s+)?\s*(F[0-9]+/[0-2][0-9]|SH[\s\d,/]+)(?:\*(\d)(?:,\d)?)?$
+    constexpr bool CRICK_serum_id(std::string_view src)
+    {
+        using namespace detail;
+        // (?:\*(\d)(?:,\d)?)?$
+        const auto suffix = [](std::string_view rest) {
+            return rest.empty() || (rest.size() == 2 && rest[0] == '*' && is_digit(rest[1])) || (rest.size() == 4 && rest[0] == '*' && is_digit(rest[1]) && rest[2] == ',' && is_digit(rest[3]));
+        };
+        const auto id_at = [&src, suffix](size_t pos) {
+            if (upper(src[pos]) == 'F') {
+                if (const auto slash = skip(src, pos + 1, is_digit); slash > (pos + 1) && (src.size() - slash) >= 3 && src[slash] == '/' && src[slash + 1] >= '0' && src[slash + 1] <= '2' && is_digit(src[slash + 2]))
+                    return suffix(src.substr(slash + 3));
+            }
+            else if (word_at(src, pos, "SH")) {
+                if (const auto end = skip(src, pos + 2, [](char cc) { return is_space(cc) || is_digit(cc) || cc == ',' || cc == '/'; }); end > (pos + 2))
+                    return suffix(src.substr(end));
+            }
+            return false;
+        };
+        // id starts at the beginning or after a space, preceded by letters and spaces only
+        for (size_t pos{0}; pos < src.size() && (is_alpha(src[pos]) || is_space(src[pos])); ++pos) {
+            if ((pos == 0 || is_space(src[pos - 1])) && id_at(pos))
+                return true;
+        }
+        return false;
+    }
+
+    // ^2-fold$
+    constexpr bool CRICK_prn_2fold(std::string_view src) { return src.size() == 6 && detail::word_at(src, 0, "2-FOLD"); }
+
+    // ^read$
+    constexpr bool CRICK_prn_read(std::string_view src) { return src.size() == 4 && detail::word_at(src, 0, "READ"); }
+
+    // ----------------------------------------------------------------------
+    // NIID
+
+    // ^\s*(?:\d+[A-Z]\s+)?([A-Z][A-Z\d\s\-_\./\(\)]+)\s+NO\s*\.\s*([\d\-]+)$
+    //  [clade] name with reassortant, serum_id
+    constexpr bool NIID_serum_name(std::string_view src)
+    {
+        using namespace detail;
+        // serum id and dot are at the end, NO before them
+        const auto id_first = [&src]() {
+            auto pos = src.size();
+            while (pos > 0 && (is_digit(src[pos - 1]) || src[pos - 1] == '-'))
+                --pos;
+            return pos;
+        }();
+        if (id_first == src.size())
+            return false;
+        auto no_end = id_first;
+        while (no_end > 0 && is_space(src[no_end - 1]))
+            --no_end;
+        if (no_end == 0 || src[no_end - 1] != '.')
+            return false;
+        --no_end;
+        while (no_end > 0 && is_space(src[no_end - 1]))
+            --no_end;
+        if (no_end < 2 || !word_at(src, no_end - 2, "NO"))
+            return false;
+        const auto name_end = no_end - 2; // name followed by at least one space
+
+        auto name_first = skip_spaces(src, 0);
+        if (name_first < src.size() && is_digit(src[name_first])) { // clade
+            const auto clade_letter = skip(src, name_first, is_digit);
+            if (clade_letter >= name_end || !is_alpha(src[clade_letter]) || !is_space(src[clade_letter + 1]))
+                return false;
+            name_first = skip_spaces(src, clade_letter + 1);
+        }
+        if (name_first >= name_end || (name_end - name_first) < 3 || !is_alpha(src[name_first]) || !is_space(src[name_end - 1]))
+            return false;
+        return all_of(src.substr(name_first, name_end - name_first), [](char cc) { return is_alpha(cc) || is_digit(cc) || is_space(cc) || cc == '-' || cc == '_' || cc == '.' || cc == '/' || cc == '(' || cc == ')'; });
+    }
+
+    // HA\s*group
+    constexpr bool NIID_serum_name_row_non_serum_label(std::string_view src)
+    {
+        using namespace detail;
+        for (size_t pos{0}; pos < src.size(); ++pos) {
+            if (word_at(src, pos, "HA") && word_at(src, skip_spaces(src, pos + 2), "GROUP"))
+                return true;
+        }
+        return false;
+    }
+
+    // ----------------------------------------------------------------------
+    // VIDRL
+
+    // ^(SL|VW)[0-9]{8}$
+    constexpr bool VIDRL_antigen_lab_id(std::string_view src) { return src.size() == 10 && (detail::word_at(src, 0, "SL") || detail::word_at(src, 0, "VW")) && detail::digits(src.substr(2), 8); }
+
+    // ^\s*Sample\s*Date\s*$
+    constexpr bool VIDRL_antigen_date_column_title(std::string_view src)
+    {
+        using namespace detail;
+        const auto first = skip_spaces(src, 0);
+        return word_at(src, first, "SAMPLE") && whole_label(src.substr(first + 6), "DATE");
+    }
+
+    // ^\s*VW\s*$
+    constexpr bool VIDRL_antigen_lab_id_column_title(std::string_view src) { return detail::whole_label(src, "VW"); }
+
+    // ^(?:[AB]/)?([A-Z][A-Z ]+)/?([0-9]+)(?:_.*)?$
+    //  optional mutant info at the end
+    constexpr bool VIDRL_serum_name(std::string_view src)
+    {
+        using namespace detail;
+        const auto name_at = [&src](size_t pos) {
+            if (pos >= src.size() || !is_alpha(src[pos]))
+                return false;
+            const auto name_end = skip(src, pos + 1, [](char cc) { return is_alpha(cc) || cc == ' '; });
+            if (name_end == (pos + 1))
+                return false;
+            const auto number_first = (name_end < src.size() && src[name_end] == '/') ? name_end + 1 : name_end;
+            const auto number_end = skip(src, number_first, is_digit);
+            if (number_end == number_first)
+                return false;
+            return number_end == src.size() || (src[number_end] == '_' && skip(src, number_end + 1, [](char cc) { return !is_line_terminator(cc); }) == src.size());
+        };
+        return name_at(0) || (src.size() > 2 && (upper(src[0]) == 'A' || upper(src[0]) == 'B') && src[1] == '/' && name_at(2));
+    }
+
+    // ^[AF][0-9][0-9][0-9][0-9]-[0-9]+D$
+    constexpr bool VIDRL_serum_id_with_days(std::string_view src)
+    {
+        using namespace detail;
+        return src.size() > 7 && (upper(src[0]) == 'A' || upper(src[0]) == 'F') && digits(src.substr(1, 4), 4) && src[5] == '-' && upper(src.back()) == 'D' && digits(src.substr(6, src.size() - 7), src.size() - 7);
+    }
+
+    // ^([AF][0-9][0-9][0-9][0-9](?:-[0-9]+D)?|F[0-9]+/[0-2][0-9])$
+    constexpr bool VIDRL_serum_id(std::string_view src)
+    {
+        using namespace detail;
+        if (src.size() == 5 && (upper(src[0]) == 'A' || upper(src[0]) == 'F') && digits(src.substr(1), 4))
+            return true;
+        if (VIDRL_serum_id_with_days(src))
+            return true;
+        if (src.size() >= 5 && upper(src[0]) == 'F') {
+            const auto slash = skip(src, 1, is_digit);
+            return slash > 1 && slash == (src.size() - 3) && src[slash] == '/' && src[slash + 1] >= '0' && src[slash + 1] <= '2' && is_digit(src[slash + 2]);
+        }
+        return false;
+    }
+
+    // ----------------------------------------------------------------------
+
+    // ^\s*(.*(HUMAN|WHO|NORMAL)|GOAT|POST? VAX)\b
+    //  "POST VAX" is in VIDRL H3 HI 2021
+    constexpr bool human_who_serum(std::string_view src)
+    {
+        using namespace detail;
+        const auto first = skip_spaces(src, 0);
+        if (label_at(src, first, "GOAT") || label_at(src, first, "POST VAX") || label_at(src, first, "POS VAX"))
+            return true;
+        // .* does not cross line terminators
+        for (size_t pos{first}; pos < src.size() && !is_line_terminator(src[pos]); ++pos) {
+            if (label_at(src, pos, "HUMAN") || label_at(src, pos, "WHO") || label_at(src, pos, "NORMAL"))
+                return true;
+        }
+        return false;
+    }
+
+    // ----------------------------------------------------------------------
+
+    static_assert(serum_passage("MDCK1") && serum_passage("cell") && serum_passage("Egg") && serum_passage("qmc2") && serum_passage("S1") && !serum_passage("X") && !serum_passage(" E") && !serum_passage(""));
+    static_assert(CDC_antigen_lab_id("2019701234") && !CDC_antigen_lab_id("201970123") && !CDC_antigen_lab_id("20197012345") && !CDC_antigen_lab_id("201970123x"));
+    static_assert(CDC_serum_index("A") && CDC_serum_index("z") && CDC_serum_index("Egg") && !CDC_serum_index("AB") && !CDC_serum_index("1") && !CDC_serum_index(""));
+    static_assert(CDC_titer_label("TITER") && CDC_titer_label(" back titer") && CDC_titer_label("BACKTITER (x)") && !CDC_titer_label("TITERS") && !CDC_titer_label("BACK") && !CDC_titer_label("x TITER"));
+    static_assert(CDC_ha_group_label("HA GROUP") && CDC_ha_group_label(" hagroup 1") && !CDC_ha_group_label("HA GROUPS") && !CDC_ha_group_label("HA"));
+    static_assert(CDC_antigen_control("INFLUENZA B CONTROL AG, YAM LINEAGE") && CDC_antigen_control("control") && CDC_antigen_control("(CONTROL)") && !CDC_antigen_control("CONTROLS") && !CDC_antigen_control("XCONTROL"));
+    static_assert(AC21_serum_index("12") && !AC21_serum_index("") && !AC21_serum_index("1 "));
+    static_assert(CRICK_serum_name_1("A/SWITZERLAND") && CRICK_serum_name_1("b/hong kong") && CRICK_serum_name_1("NYMC X-181") && CRICK_serum_name_1("NYMC  X-327A") && !CRICK_serum_name_1("NYMCX-181") && !CRICK_serum_name_1("A/") && !CRICK_serum_name_1("A/HK1"));
+    static_assert(CRICK_serum_name_2("8060/17") && CRICK_serum_name_2("egg-1") && !CRICK_serum_name_2("") && !CRICK_serum_name_2("8060 17"));
+    static_assert(CRICK_serum_id("F12/19") && CRICK_serum_id("EGG F12/19") && CRICK_serum_id("  F123/09*1") && CRICK_serum_id("F1/20*1,2") && CRICK_serum_id("SH 1,2/3") && CRICK_serum_id("sh563 *2"));
+    static_assert(!CRICK_serum_id("F12/39") && !CRICK_serum_id("XF12/19") && !CRICK_serum_id("EGG1 F12/19") && !CRICK_serum_id("F12/19*") && !CRICK_serum_id("SH") && !CRICK_serum_id("F/19"));
+    static_assert(CRICK_prn_2fold("2-Fold") && !CRICK_prn_2fold("2-fold ") && CRICK_prn_read("READ") && !CRICK_prn_read("reads"));
+    static_assert(NIID_serum_name("A/TEXAS/50/2012 NO. 12") && NIID_serum_name("3C A/Hong Kong/4801/2014\nEGG NO.2-1") && NIID_serum_name("1A A/NIID  No .5") && NIID_serum_name(" X-181 EGG no.\n3"));
+    static_assert(!NIID_serum_name("A/TEXAS/50/2012NO. 12") && !NIID_serum_name("A NO. 12") && !NIID_serum_name("A/TEXAS/50/2012 NO. ") && !NIID_serum_name("1 A/NIID NO. 5") && !NIID_serum_name("A/TEXAS;50 NO. 1"));
+    static_assert(NIID_serum_name_row_non_serum_label("HA group") && NIID_serum_name_row_non_serum_label("(HA\ngroup)") && !NIID_serum_name_row_non_serum_label("HA grp"));
+    static_assert(VIDRL_antigen_lab_id("VW20150001") && VIDRL_antigen_lab_id("sl12345678") && !VIDRL_antigen_lab_id("VW2015000") && !VIDRL_antigen_lab_id("XW20150001"));
+    static_assert(VIDRL_antigen_date_column_title(" Sample Date ") && VIDRL_antigen_date_column_title("sampledate") && !VIDRL_antigen_date_column_title("Sample Dates"));
+    static_assert(VIDRL_antigen_lab_id_column_title(" VW ") && VIDRL_antigen_lab_id_column_title("vw") && !VIDRL_antigen_lab_id_column_title("VW1"));
+    static_assert(VIDRL_serum_name("A/BRISBANE/02/2018") == false && VIDRL_serum_name("A/BRISBANE02") && VIDRL_serum_name("SOUTH AUSTRALIA/34_T135K") && VIDRL_serum_name("HK 4801") && !VIDRL_serum_name("A/B1") && !VIDRL_serum_name("HK"));
+    static_assert(VIDRL_serum_id_with_days("A8529-14D") && VIDRL_serum_id_with_days("f1234-1d") && !VIDRL_serum_id_with_days("A8529-D") && !VIDRL_serum_id_with_days("A852-14D"));
+    static_assert(VIDRL_serum_id("A8529") && VIDRL_serum_id("F8529-21D") && VIDRL_serum_id("F12/19") && !VIDRL_serum_id("A12/19") && !VIDRL_serum_id("F12/31") && !VIDRL_serum_id("A85291"));
+    static_assert(human_who_serum("HUMAN POOL") && human_who_serum(" pooled human serum") && human_who_serum("WHO") && human_who_serum("Goat anti") && human_who_serum("POS VAX") && human_who_serum("POST VAX 1"));
+    static_assert(!human_who_serum("WHOLE") && !human_who_serum("GOATS") && !human_who_serum("A POST VAX") && !human_who_serum("SERUM\nHUMAN") && !human_who_serum("NORMALISED"));
+
+} // namespace acmacs::sheet::inline v1::anchor
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -1,106 +1,585 @@
-#include <stack>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <thread>
+#include <fcntl.h>
+#include <lzma.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#include "acmacs-base/read-file.hh"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "acmacs-base/float.hh"
+#include "acmacs-base/string-compare.hh"
+#include "acmacs-whocc/log.hh"
 #include "acmacs-whocc/csv-parser.hh"
 
-enum class state {
-    cell,
-    quoted,
-    escaped
-};
+using format_t = acmacs::xlsx::csv::format_t;
 
-constexpr const char separator{','};
-constexpr const char quote{'"'};
-constexpr const char escape{'\\'};
+static acmacs::sheet::cell_grid_t read_csv(std::string_view filename, const format_t& format, size_t number_of_threads);
 
 // ----------------------------------------------------------------------
 
-acmacs::xlsx::v1::csv::Sheet::Sheet(std::string_view filename)
+acmacs::xlsx::v1::csv::format_t acmacs::xlsx::v1::csv::format_from_filename(std::string_view filename)
 {
-    const std::string src{acmacs::file::read(filename)};
+    if (acmacs::string::endswith_ignore_case(filename, ".tsv") || acmacs::string::endswith_ignore_case(filename, ".tsv.xz"))
+        return {.separator = '\t'};
+    return {};
+
+} // acmacs::xlsx::v1::csv::format_from_filename
+
+// ----------------------------------------------------------------------
+
+acmacs::xlsx::v1::csv::Sheet::Sheet(std::string_view filename, const format_t& format, size_t number_of_threads) : GridSheet{std::string_view{}, read_csv(filename, format, number_of_threads)}
+{
+    AD_INFO("csv: rows: {} cols: {}", number_of_rows(), number_of_columns());
+
+} // acmacs::xlsx::v1::csv::Sheet::Sheet
 
-    const auto convert_cell = [&]() {};
+// ----------------------------------------------------------------------
+
+namespace
+{
+    // read only memory mapping of the whole file
+    class mapped_file_t
+    {
+      public:
+        mapped_file_t(std::string_view filename)
+        {
+            const std::string fname{filename};
+            if (fd_ = ::open(fname.c_str(), O_RDONLY); fd_ < 0)
+                throw std::runtime_error{fmt::format("cannot open {}: {}", filename, std::strerror(errno))};
+            struct stat st;
+            if (::fstat(fd_, &st) != 0) {
+                ::close(fd_);
+                throw std::runtime_error{fmt::format("cannot stat {}: {}", filename, std::strerror(errno))};
+            }
+            if (size_ = static_cast<size_t>(st.st_size); size_ > 0) {
+                if (auto* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0); mapped != MAP_FAILED) {
+                    data_ = static_cast<const char*>(mapped);
+                    ::madvise(mapped, size_, MADV_SEQUENTIAL);
+                }
+                else {
+                    ::close(fd_);
+                    throw std::runtime_error{fmt::format("cannot mmap {}: {}", filename, std::strerror(errno))};
+                }
+            }
+        }
+
+        ~mapped_file_t()
+        {
+            if (data_)
+                ::munmap(const_cast<char*>(data_), size_);
+            ::close(fd_);
+        }
 
-    const auto new_cell = [&]() {
-        convert_cell();
-        data_.back().emplace_back(std::string{});
+        mapped_file_t(const mapped_file_t&) = delete;
+        mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+        std::string_view data() const { return data_ ? std::string_view{data_, size_} : std::string_view{}; }
+
+      private:
+        int fd_{-1};
+        const char* data_{nullptr};
+        size_t size_{0};
     };
 
-    const auto new_row = [&]() {
-        convert_cell();
-        number_of_columns_ = std::max(number_of_columns_, sheet::ncol_t{data_.back().size()});
-        data_.emplace_back().emplace_back(std::string{});
+    // ----------------------------------------------------------------------
+
+    // the first of the four symbols (may repeat) in [first, last), last if none
+    inline const char* find_any(const char* first, const char* last, const std::array<char, 4>& symbols)
+    {
+#if defined(__AVX2__)
+        {
+            const auto sym0 = _mm256_set1_epi8(symbols[0]), sym1 = _mm256_set1_epi8(symbols[1]), sym2 = _mm256_set1_epi8(symbols[2]), sym3 = _mm256_set1_epi8(symbols[3]);
+            for (; last - first >= 32; first += 32) {
+                const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                const auto hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, sym0), _mm256_cmpeq_epi8(chunk, sym1)),
+                                                  _mm256_or_si256(_mm256_cmpeq_epi8(chunk, sym2), _mm256_cmpeq_epi8(chunk, sym3)));
+                if (const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits)); mask != 0)
+                    return first + std::countr_zero(mask);
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        {
+            const auto sym0 = _mm_set1_epi8(symbols[0]), sym1 = _mm_set1_epi8(symbols[1]), sym2 = _mm_set1_epi8(symbols[2]), sym3 = _mm_set1_epi8(symbols[3]);
+            for (; last - first >= 16; first += 16) {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const auto hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, sym0), _mm_cmpeq_epi8(chunk, sym1)), _mm_or_si128(_mm_cmpeq_epi8(chunk, sym2), _mm_cmpeq_epi8(chunk, sym3)));
+                if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits)); mask != 0)
+                    return first + std::countr_zero(mask);
+            }
+        }
+#endif
+        for (; first < last; ++first) {
+            if (*first == symbols[0] || *first == symbols[1] || *first == symbols[2] || *first == symbols[3])
+                break;
+        }
+        return first;
+    }
+
+    // ----------------------------------------------------------------------
+
+    // cells of all rows one after another, cells are views into the source
+    // or, if they contain quotes or escapes, into unescaped
+    struct parsed_t
+    {
+        std::vector<std::string_view> cells;
+        std::vector<size_t> row_start; // index of the first cell of each row in cells
+        std::deque<std::string> unescaped; // deque: stable references
+
+        size_t number_of_rows() const { return row_start.size(); }
+        size_t row_size(size_t row) const { return (row + 1 < row_start.size() ? row_start[row + 1] : cells.size()) - row_start[row]; }
     };
 
-    const auto append = [&](char sym) {
-        std::visit(
-            [sym]<typename Content>(Content& content) {
-                if constexpr (std::is_same_v<Content, std::string>)
-                    content.push_back(sym);
-            },
-            data_.back().back());
+    // quote toggles quoted state and is not a part of the cell, escaped char is taken as is
+    inline void parse(std::string_view source, const format_t& format, parsed_t& target)
+    {
+        const std::array<char, 4> specials{format.separator, '\n', format.quote, format.escape};
+        const char* pos = source.data();
+        const char* const end = source.data() + source.size();
+        const char* cell_begin = pos;
+        std::string* buffer{nullptr}; // cell contains quotes or escapes
+        bool quoted{false};
+
+        const auto finish_cell = [&](const char* cell_end) {
+            target.cells.push_back(buffer ? std::string_view{*buffer} : std::string_view{cell_begin, static_cast<size_t>(cell_end - cell_begin)});
+            buffer = nullptr;
+        };
+
+        const auto use_buffer = [&](const char* cell_end) {
+            if (!buffer)
+                buffer = &target.unescaped.emplace_back(cell_begin, cell_end);
+        };
+
+        target.row_start.push_back(target.cells.size());
+        while (pos < end) {
+            const auto* special = find_any(pos, end, specials);
+            if (buffer)
+                buffer->append(pos, special);
+            if (special == end)
+                break;
+            if (*special == format.separator || *special == '\n') {
+                if (quoted) {
+                    buffer->push_back(*special);
+                }
+                else {
+                    finish_cell(special);
+                    if (*special == '\n')
+                        target.row_start.push_back(target.cells.size());
+                    cell_begin = special + 1;
+                }
+                pos = special + 1;
+            }
+            else if (*special == format.quote) {
+                use_buffer(special);
+                quoted = !quoted;
+                pos = special + 1;
+            }
+            else { // escape
+                use_buffer(special);
+                if (special + 1 < end) {
+                    buffer->push_back(special[1]);
+                    pos = special + 2;
+                }
+                else
+                    pos = end;
+            }
+        }
+        finish_cell(end);
+    }
+
+    // ----------------------------------------------------------------------
+    // Parallel parsing: the source is split at newlines outside of quoted
+    // text, chunks are parsed concurrently. Quoted state at the nominal
+    // split points is derived from the quote parity of the preceding
+    // chunks, the parity pre-pass runs concurrently as well.
+
+    constexpr const size_t minimal_chunk_size{4 * 1024 * 1024};
+
+    template <typename F> void run_concurrently(size_t number_of_tasks, F task)
+    {
+        std::vector<std::future<void>> workers;
+        for (size_t task_no = 1; task_no < number_of_tasks; ++task_no)
+            workers.push_back(std::async(std::launch::async, task, task_no));
+        task(0);
+        for (auto& result : workers)
+            result.get(); // rethrows exception of the worker
+    }
+
+    struct quote_parity_t
+    {
+        bool odd_quotes{false};
+        bool escape_pending{false}; // ends with escape, the first char of the next chunk is taken as is
     };
 
-    std::stack<enum state> states;
-    states.push(state::cell);
-    data_.emplace_back().emplace_back(std::string{});
-    for (const char sym : src) {
-        if (states.top() == state::escaped) {
-            states.pop();
-            append(sym);
-        }
-        else {
-            switch (sym) {
-                case separator:
-                    if (states.top() == state::quoted)
-                        append(sym);
-                    else
-                        new_cell();
-                    break;
-                case '\n':
-                    if (states.top() == state::quoted)
-                        append(sym);
-                    else
-                        new_row();
-                    break;
-                case quote:
-                    if (states.top() == state::quoted)
-                        states.pop();
+    inline quote_parity_t quote_parity(const char* first, const char* last, const format_t& format)
+    {
+        const std::array<char, 4> specials{format.quote, format.escape, format.quote, format.escape};
+        quote_parity_t result;
+        while ((first = find_any(first, last, specials)) != last) {
+            if (*first == format.quote) {
+                result.odd_quotes = !result.odd_quotes;
+                ++first;
+            }
+            else if (first + 1 < last)
+                first += 2;
+            else {
+                result.escape_pending = true;
+                ++first;
+            }
+        }
+        return result;
+    }
+
+    // position after the first newline outside of quoted text, nullptr if there is none
+    inline const char* record_boundary(const char* first, const char* last, bool quoted, const format_t& format)
+    {
+        const std::array<char, 4> specials{'\n', format.quote, format.escape, '\n'};
+        while ((first = find_any(first, last, specials)) != last) {
+            if (*first == '\n') {
+                if (!quoted)
+                    return first + 1;
+                ++first;
+            }
+            else if (*first == format.quote) {
+                quoted = !quoted;
+                ++first;
+            }
+            else
+                first = std::min(first + 2, last);
+        }
+        return nullptr;
+    }
+
+    // chunks in the source order, each chunk starts a new row
+    inline std::vector<parsed_t> parse_chunks(std::string_view source, const format_t& format, size_t number_of_threads)
+    {
+        if (number_of_threads == 0)
+            number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        const size_t number_of_splits = std::min(number_of_threads, source.size() / minimal_chunk_size);
+        if (number_of_splits < 2) {
+            std::vector<parsed_t> chunks(1);
+            parse(source, format, chunks.front());
+            return chunks;
+        }
+
+        const char* const begin = source.data();
+        const char* const end = begin + source.size();
+        std::vector<const char*> split(number_of_splits + 1);
+        for (size_t split_no = 0; split_no <= number_of_splits; ++split_no)
+            split[split_no] = begin + source.size() * split_no / number_of_splits;
+        std::vector<quote_parity_t> parity(number_of_splits);
+        run_concurrently(number_of_splits, [&](size_t split_no) { parity[split_no] = quote_parity(split[split_no], split[split_no + 1], format); });
+
+        std::vector<const char*> boundary{begin};
+        bool quoted{false}, escape_pending{false};
+        for (size_t split_no = 1; split_no < number_of_splits; ++split_no) {
+            // escape at the end of the previous chunk is rare, its chunk is re-scanned without the escaped char
+            const auto previous = escape_pending ? quote_parity(split[split_no - 1] + 1, split[split_no], format) : parity[split_no - 1];
+            quoted ^= previous.odd_quotes;
+            escape_pending = previous.escape_pending;
+            if (split[split_no] < boundary.back())
+                continue; // record of the previous boundary spans over this split point
+            const auto* found = record_boundary(split[split_no] + (escape_pending ? 1 : 0), end, quoted, format);
+            if (!found || found == end)
+                break;
+            boundary.push_back(found);
+        }
+        boundary.push_back(end);
+
+        std::vector<parsed_t> chunks(boundary.size() - 1);
+        run_concurrently(chunks.size(), [&](size_t chunk_no) {
+            parse(std::string_view{boundary[chunk_no], static_cast<size_t>(boundary[chunk_no + 1] - boundary[chunk_no])}, format, chunks[chunk_no]);
+        });
+        // all but the last chunk end with newline, parse() adds an empty row after it
+        for (auto chunk = chunks.begin(); chunk != std::prev(chunks.end()); ++chunk) {
+            chunk->cells.resize(chunk->row_start.back());
+            chunk->row_start.pop_back();
+        }
+        return chunks;
+    }
+
+    // ----------------------------------------------------------------------
+
+    constexpr bool is_digit(char cc) { return cc >= '0' && cc <= '9'; }
+
+    // YYYY-MM-DD, as written for date cells by xlsx2csv and most exporters
+    inline std::optional<date::year_month_day> infer_date(std::string_view src)
+    {
+        if (src.size() != 10 || src[4] != '-' || src[7] != '-')
+            return std::nullopt;
+        for (const size_t pos : {0, 1, 2, 3, 5, 6, 8, 9}) {
+            if (!is_digit(src[pos]))
+                return std::nullopt;
+        }
+        const auto number = [src](size_t first, size_t size) {
+            unsigned result{0};
+            for (const char cc : src.substr(first, size))
+                result = result * 10 + static_cast<unsigned>(cc - '0');
+            return result;
+        };
+        if (const date::year_month_day result{date::year{static_cast<int>(number(0, 4))}, date::month{number(5, 2)}, date::day{number(8, 2)}}; result.ok())
+            return result;
+        return std::nullopt;
+    }
+
+    // Sets cell typed the way xlsx backends type it: whole numbers are long,
+    // other numbers double, ISO dates year_month_day, everything else
+    // string, empty cells are left empty. Numbers with leading zeros (lab
+    // ids) and with surrounding spaces are kept as strings.
+    inline void set_cell(acmacs::sheet::cell_grid_t& grid, acmacs::sheet::nrow_t row, acmacs::sheet::ncol_t col, std::string_view src)
+    {
+        if (src.empty())
+            return; // grid cell is empty already
+
+        const size_t first_digit = src[0] == '-' ? 1 : 0;
+        if (first_digit < src.size() && (is_digit(src[first_digit]) || src[first_digit] == '.')) {
+            const bool leading_zero = src[first_digit] == '0' && first_digit + 1 < src.size() && is_digit(src[first_digit + 1]);
+            if (!leading_zero) {
+                const auto parsed = [src](auto& value) {
+                    const auto [ptr, ec] = std::from_chars(src.data(), src.data() + src.size(), value);
+                    return ec == std::errc{} && ptr == src.data() + src.size();
+                };
+                if (long value{0}; parsed(value)) {
+                    grid.set(row, col, value);
+                    return;
+                }
+                if (double value{0}; parsed(value) && std::isfinite(value)) {
+                    if (!float_equal(value, std::round(value)) || std::abs(value) >= 9e18) // out of long range
+                        grid.set(row, col, value);
                     else
-                        states.push(state::quoted);
-                    break;
-                case escape:
-                    states.push(state::escaped);
-                    break;
-                default:
-                    append(sym);
-                    break;
+                        grid.set(row, col, static_cast<long>(std::llround(value)));
+                    return;
+                }
+            }
+            if (const auto date = infer_date(src); date.has_value()) {
+                grid.set(row, col, *date);
+                return;
             }
         }
+        grid.set_string(row, col, src);
     }
 
-    if (!data_.empty() && data_.back().size() <= 1 && number_of_columns_ > sheet::ncol_t{1})
-        data_.erase(std::prev(data_.end()));
+} // namespace
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::cell_grid_t read_csv(std::string_view filename, const format_t& format, size_t number_of_threads)
+{
+    using namespace acmacs::sheet;
+
+    const mapped_file_t source{filename};
+    if (source.data().empty())
+        return {};
+    auto chunks = parse_chunks(source.data(), format, number_of_threads);
 
-    // normalize number of columns
-    for (auto& row : data_) {
-        while (row.size() < *number_of_columns_)
-            row.emplace_back(std::string{});
+    size_t number_of_rows{0}, number_of_columns{0};
+    for (const auto& chunk : chunks) {
+        number_of_rows += chunk.number_of_rows();
+        for (size_t row = 0; row < chunk.number_of_rows(); ++row)
+            number_of_columns = std::max(number_of_columns, chunk.row_size(row));
+    }
+    // trailing newline
+    if (auto& last = chunks.back(); last.number_of_rows() > 0 && last.row_size(last.number_of_rows() - 1) <= 1 && number_of_columns > 1) {
+        last.cells.resize(last.row_start.back());
+        last.row_start.pop_back();
+        --number_of_rows;
     }
 
-    AD_INFO("csv: rows: {} cols: {}", number_of_rows(), number_of_columns());
-    // for (const auto& row : data_) {
-    //     bool first{true};
-    //     for (const auto& cell : row) {
-    //         if (first)
-    //             first = false;
-    //         else
-    //             fmt::print("|");
-    //         fmt::print("{}", cell);
-    //     }
-    //     fmt::print("\n");
-    // }
-}
+    // rows shorter than number_of_columns are not padded, cells past the row end stay empty in the grid
+    cell_grid_t grid{nrow_t{number_of_rows}, ncol_t{number_of_columns}};
+    size_t grid_row{0};
+    for (const auto& chunk : chunks) {
+        for (size_t row = 0; row < chunk.number_of_rows(); ++row, ++grid_row) {
+            const auto* row_cells = chunk.cells.data() + chunk.row_start[row];
+            for (size_t col = 0; col < chunk.row_size(row); ++col)
+                set_cell(grid, nrow_t{grid_row}, ncol_t{col}, row_cells[col]);
+        }
+    }
+    return grid;
+
+} // read_csv
+
+// ----------------------------------------------------------------------
+
+// file content in blocks, .xz files are decompressed on the fly
+class acmacs::xlsx::v1::csv::grouped_records_t::source_t
+{
+  public:
+    source_t(std::string_view filename) : filename_{filename}, xz_{acmacs::string::endswith_ignore_case(filename, ".xz")}
+    {
+        if (fd_ = ::open(filename_.c_str(), O_RDONLY); fd_ < 0)
+            throw std::runtime_error{fmt::format("cannot open {}: {}", filename, std::strerror(errno))};
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (xz_) {
+            if (const auto ret = lzma_stream_decoder(&lzma_, UINT64_MAX, LZMA_CONCATENATED); ret != LZMA_OK) {
+                ::close(fd_);
+                throw std::runtime_error{fmt::format("cannot initialize xz decoder for {}: {}", filename, static_cast<int>(ret))};
+            }
+        }
+    }
+
+    ~source_t()
+    {
+        if (xz_)
+            lzma_end(&lzma_);
+        ::close(fd_);
+    }
+
+    source_t(const source_t&) = delete;
+    source_t& operator=(const source_t&) = delete;
+
+    // appends next block to target, false at the end of file
+    bool read(std::string& target)
+    {
+        const auto old_size = target.size();
+        target.resize(old_size + block_size);
+        const auto added = xz_ ? decompress(target.data() + old_size, block_size) : read_raw(target.data() + old_size, block_size);
+        target.resize(old_size + added);
+        return added > 0;
+    }
+
+  private:
+    static constexpr const size_t block_size{1024 * 1024};
+
+    std::string filename_;
+    int fd_{-1};
+    bool xz_;
+    lzma_stream lzma_ = LZMA_STREAM_INIT;
+    std::vector<uint8_t> compressed_;
+    bool compressed_eof_{false};
+
+    size_t read_raw(void* target, size_t size)
+    {
+        for (;;) {
+            if (const auto bytes = ::read(fd_, target, size); bytes >= 0)
+                return static_cast<size_t>(bytes);
+            else if (errno != EINTR)
+                throw std::runtime_error{fmt::format("cannot read {}: {}", filename_, std::strerror(errno))};
+        }
+    }
+
+    size_t decompress(char* target, size_t size)
+    {
+        lzma_.next_out = reinterpret_cast<uint8_t*>(target);
+        lzma_.avail_out = size;
+        while (lzma_.avail_out > 0) {
+            if (lzma_.avail_in == 0 && !compressed_eof_) {
+                compressed_.resize(block_size);
+                compressed_.resize(read_raw(compressed_.data(), compressed_.size()));
+                compressed_eof_ = compressed_.empty();
+                lzma_.next_in = compressed_.data();
+                lzma_.avail_in = compressed_.size();
+            }
+            if (const auto ret = lzma_code(&lzma_, compressed_eof_ ? LZMA_FINISH : LZMA_RUN); ret == LZMA_STREAM_END)
+                break;
+            else if (ret != LZMA_OK)
+                throw std::runtime_error{fmt::format("cannot decompress {}: xz error {}", filename_, static_cast<int>(ret))};
+        }
+        return size - lzma_.avail_out;
+    }
+
+    std::string buffer_;
+    size_t pos_{0};
+    bool eof_{false};
+
+    friend class grouped_records_t;
+};
+
+// ----------------------------------------------------------------------
+
+acmacs::xlsx::v1::csv::grouped_records_t::grouped_records_t(std::string_view filename, std::string_view key_column, const format_t& format)
+    : source_{std::make_unique<source_t>(filename)}, format_{format}
+{
+    if (!read_record(header_))
+        throw std::runtime_error{fmt::format("{}: no header", filename)};
+    if (const auto key = column(key_column); key.has_value())
+        key_column_ = *key;
+    else
+        throw std::runtime_error{fmt::format("{}: no key column \"{}\" in the header", filename, key_column)};
+    records_read_ = 0;
+
+} // acmacs::xlsx::v1::csv::grouped_records_t::grouped_records_t
+
+// ----------------------------------------------------------------------
+
+acmacs::xlsx::v1::csv::grouped_records_t::~grouped_records_t() = default;
+
+// ----------------------------------------------------------------------
+
+std::optional<size_t> acmacs::xlsx::v1::csv::grouped_records_t::column(std::string_view name) const
+{
+    if (const auto found = std::find(std::begin(header_), std::end(header_), name); found != std::end(header_))
+        return static_cast<size_t>(found - std::begin(header_));
+    return std::nullopt;
+
+} // acmacs::xlsx::v1::csv::grouped_records_t::column
+
+// ----------------------------------------------------------------------
+
+bool acmacs::xlsx::v1::csv::grouped_records_t::next(std::vector<record_t>& group)
+{
+    group.clear();
+    if (!has_pending_ && !read_record(pending_))
+        return false;
+    group.push_back(std::move(pending_));
+    has_pending_ = false;
+    while (read_record(pending_)) {
+        if (pending_[key_column_] != group.front()[key_column_]) {
+            has_pending_ = true;
+            break;
+        }
+        group.push_back(std::move(pending_));
+    }
+    return true;
+
+} // acmacs::xlsx::v1::csv::grouped_records_t::next
+
+// ----------------------------------------------------------------------
+
+bool acmacs::xlsx::v1::csv::grouped_records_t::read_record(record_t& record)
+{
+    auto& src = *source_;
+    for (;;) {
+        const char* first = src.buffer_.data() + src.pos_;
+        const char* last = src.buffer_.data() + src.buffer_.size();
+        const char* end = record_boundary(first, last, false, format_);
+        if (!end && src.eof_ && first < last)
+            end = last;
+        if (end) {
+            src.pos_ += static_cast<size_t>(end - first);
+            std::string_view text{first, static_cast<size_t>(end - first)};
+            if (text.ends_with('\n'))
+                text.remove_suffix(text.ends_with("\r\n") ? 2 : 1);
+            if (text.empty())
+                continue; // empty line
+            parsed_t parsed;
+            parse(text, format_, parsed);
+            record.assign(std::begin(parsed.cells), std::end(parsed.cells));
+            if (record.size() < header_.size())
+                record.resize(header_.size());
+            ++records_read_;
+            return true;
+        }
+        if (src.eof_)
+            return false;
+        // incomplete record in the buffer: drop consumed part, read next block
+        src.buffer_.erase(0, src.pos_);
+        src.pos_ = 0;
+        src.eof_ = !src.read(src.buffer_);
+    }
+
+} // acmacs::xlsx::v1::csv::grouped_records_t::read_record
 
 // ----------------------------------------------------------------------
 /// Local Variables:
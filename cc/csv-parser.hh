@@ -1,6 +1,6 @@
 #pragma once
 
-#include "acmacs-whocc/sheet.hh"
+#include "acmacs-whocc/sheet-grid.hh"
 
 // ----------------------------------------------------------------------
 
@@ -8,33 +8,72 @@ namespace acmacs::xlsx::inline v1
 {
     namespace csv
     {
-        class Sheet : public acmacs::sheet::Sheet
+        struct format_t
         {
-          public:
-            Sheet(std::string_view filename);
+            char separator{','};
+            char quote{'"'}; // toggles quoted state, separators and newlines in quoted text are part of the cell
+            char escape{'\\'}; // next char is taken as is
+        };
 
-            sheet::nrow_t number_of_rows() const override { return sheet::nrow_t{data_.size()}; }
-            sheet::ncol_t number_of_columns() const override { return number_of_columns_; }
-            std::string name() const override { return {}; }
-            acmacs::sheet::cell_t cell(sheet::nrow_t row, sheet::ncol_t col) const override { return data_.at(*row).at(*col); } // row and col are zero based
+        // .tsv and .tsv.xz files are tab separated
+        format_t format_from_filename(std::string_view filename);
 
-          private:
-            std::vector<std::vector<acmacs::sheet::cell_t>> data_;
-            sheet::ncol_t number_of_columns_{0};
+        // csv file is parsed into cell grid, it is a single sheet without name
+        // empty cells and cells past the end of short rows are cell::empty, as in xlsx
+        class Sheet : public acmacs::sheet::GridSheet
+        {
+          public:
+            // files of several Mb are split at record boundaries and parsed by number_of_threads (0: hardware concurrency)
+            Sheet(std::string_view filename, const format_t& format, size_t number_of_threads = 0);
         };
 
         class Doc
         {
           public:
-            Doc(std::string_view filename) : sheet_{std::make_shared<Sheet>(filename)} {}
+            Doc(std::string_view filename) : sheet_{std::make_shared<Sheet>(filename, format_from_filename(filename))} {}
 
             size_t number_of_sheets() const { return 1; }
+            acmacs::sheet::sheet_info_t sheet_info(size_t /*sheet_no*/) const { return {.name = sheet_->name(), .dimension = acmacs::sheet::cell_addr_t{sheet_->number_of_rows(), sheet_->number_of_columns()}}; }
             std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t /*sheet_no*/) { return sheet_; }
 
           private:
             std::shared_ptr<Sheet> sheet_;
         };
 
+        // ----------------------------------------------------------------------
+
+        // Streaming reader of a csv/tsv file (plain or .xz) with a header row. Consecutive records with
+        // the same value in the key column are returned as a group, only the current group and the read
+        // buffer are kept in memory.
+        class grouped_records_t
+        {
+          public:
+            using record_t = std::vector<std::string>; // fields of a record, padded to the header size
+
+            grouped_records_t(std::string_view filename, std::string_view key_column, const format_t& format);
+            ~grouped_records_t();
+
+            const record_t& header() const { return header_; }
+            std::optional<size_t> column(std::string_view name) const;
+            size_t records_read() const { return records_read_; }
+
+            // next group of records, false at the end of file
+            bool next(std::vector<record_t>& group);
+
+          private:
+            class source_t;
+
+            std::unique_ptr<source_t> source_;
+            format_t format_;
+            record_t header_;
+            size_t key_column_{0};
+            record_t pending_; // first record of the next group
+            bool has_pending_{false};
+            size_t records_read_{0};
+
+            bool read_record(record_t& record);
+        };
+
     } // namespace csv
 
 } // namespace acmacs::xlsx::inline v1
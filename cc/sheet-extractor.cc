@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <future>
+#include <thread>
+
 #include "acmacs-base/range-v3.hh"
 #include "acmacs-base/enumerate.hh"
 #include "acmacs-base/string-compare.hh"
@@ -6,7 +10,9 @@
 #include "acmacs-virus/virus-name-normalize.hh"
 #include "acmacs-virus/passage.hh"
 #include "acmacs-whocc/log.hh"
+#include "acmacs-whocc/sheet-grid.hh"
 #include "acmacs-whocc/sheet-extractor.hh"
+#include "acmacs-whocc/anchor-lexer.hh"
 #include "acmacs-whocc/whocc-xlsx-to-torg-py.hh"
 
 // ----------------------------------------------------------------------
@@ -18,49 +24,36 @@
 // static const std::regex re_table_title_crick{R"(^Table\s+[XY0-9-]+\s*\.\s*Antigenic analys[ie]s of influenza ([AB](?:\(H3N2\)|\(H1N1\)pdm09)?)\s*viruses\s*-?\s*\(?(Plaque\s+Reduction\s+Neutralisation\s*\(MDCK-SIAT\)|(?:Victoria|Yamagata)\s+lineage)?\)?\s*\(?(20[0-2][0-9]-[01][0-9]-[0-3][0-9])\)?)", acmacs::regex::icase};
 
 // static const std::regex re_antigen_passage{"^(MDCK|QMC|C|SIAT|S|E|HCK|X)[0-9X]", acmacs::regex::icase};
-static const std::regex re_serum_passage{"^(MDCK|QMC|C|SIAT|S|E|HCK|CELL|EGG)", acmacs::regex::icase};
 
 // static const std::regex re_CDC_antigen_passage{R"(^((?:MDCK|SIAT|S|E|HCK|QMC|C|X)[0-9X][^\s\(]*)\s*(?:\(([\d/]+)\))?[A-Z]*$)", acmacs::regex::icase};
-static const std::regex re_CDC_antigen_lab_id{"^[0-9]{10}$", acmacs::regex::icase};
-static const std::regex re_CDC_serum_index{"^([A-Z]|EGG)$", acmacs::regex::icase}; // EGG is excel auto-correction artefact
-static const std::regex re_CDC_serum_control{R"(^\s*SERUM\s+CONTROL\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_lot_label{R"(^\s*LOT\s*#?\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_date_label{R"(^\s*DATE\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_treated_label{R"(^\s*TREATED\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_date_treated_label{R"(^\s*DATE\s+TREATED\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_species_label{R"(^\s*SPECIES\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_boosted_label{R"(^\s*BOOSTED\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_conc_label{R"(^\s*CONC\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_dilut_label{R"(^\s*DILUT\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_passage_label{R"(^\s*PASSAGE\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_pool_label{R"(^\s*POOL\s*$)", acmacs::regex::icase};
-static const std::regex re_CDC_titer_label{R"(^\s*(BACK)?\s*TITER\b)", acmacs::regex::icase};
-static const std::regex re_CDC_ha_group_label{R"(^\s*HA\s*GROUP\b)", acmacs::regex::icase};
-static const std::regex re_CDC_antigen_control{R"(\bCONTROL\b)", acmacs::regex::icase};
-
-static const std::regex re_AC21_serum_index{R"(^[0-9]+$)", acmacs::regex::icase};
-static const std::regex re_AC21_ID_label{R"(^\s*ID\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_serum_label{R"(^\s*serum\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_date_label{R"(^\s*date\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_species_label{R"(^\s*SPECIES\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_treat_label{R"(^\s*treat\.?\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_type_label{R"(^\s*TYPE\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_batch_label{R"(^\s*BATCH\s*#?\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_comment_label{R"(^\s*COMMENT\s*$)", acmacs::regex::icase};
-static const std::regex re_AC21_empty{R"(^\s*$)", acmacs::regex::icase};
-
-static const std::regex re_CRICK_serum_name_1{"^([AB]/[A-Z '_-]+|NYMC\\s+X-[0-9]+[A-Z]*)$", acmacs::regex::icase};
-static const std::regex re_CRICK_serum_name_2{"^[A-Z0-9-/]+$", acmacs::regex::icase};
-#define pattern_CRICK_serum_id "F[0-9]+/[0-2][0-9]"
+static const acmacs::sheet::anchored_label_t re_CDC_serum_control{R"(^\s*SERUM\s+CONTROL\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_lot_label{R"(^\s*LOT\s*#?\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_date_label{R"(^\s*DATE\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_treated_label{R"(^\s*TREATED\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_date_treated_label{R"(^\s*DATE\s+TREATED\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_species_label{R"(^\s*SPECIES\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_boosted_label{R"(^\s*BOOSTED\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_conc_label{R"(^\s*CONC\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_dilut_label{R"(^\s*DILUT\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_passage_label{R"(^\s*PASSAGE\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_CDC_pool_label{R"(^\s*POOL\s*$)", acmacs::regex::icase};
+
+static const acmacs::sheet::anchored_label_t re_AC21_ID_label{R"(^\s*ID\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_serum_label{R"(^\s*serum\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_date_label{R"(^\s*date\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_species_label{R"(^\s*SPECIES\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_treat_label{R"(^\s*treat\.?\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_type_label{R"(^\s*TYPE\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_batch_label{R"(^\s*BATCH\s*#?\s*$)", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_AC21_comment_label{R"(^\s*COMMENT\s*$)", acmacs::regex::icase};
+
+// submatches of the regexes below are used to extract fields, rows and columns are found by the matchers in anchor-lexer.hh
 static const std::regex re_CRICK_serum_id{R"(^(?:[A-Z\s]+\s+)?\s*(F[0-9]+/[0-2][0-9]|SH[\s\d,/]+)(?:\*(\d)(?:,\d)?)?$)", acmacs::regex::icase};
 static const std::regex re_CRICK_less_than{R"(^\s*<\s*=\s*(<\d+)\s*$)", acmacs::regex::icase};
 static const std::regex re_CRICK_less_than_2{R"(^Superscripts.*\s+(\d)\s*<\s*=\s*(<\d+)\s*$)", acmacs::regex::icase};
 static const std::regex re_CRICK_less_than_multi{R"(^\s*\d\s*<\s*=\s*<\d+\s*[;,])", acmacs::regex::icase};
 static const std::regex re_CRICK_less_than_multi_entry{R"(^\s*(\d)\s*<\s*=\s*(<\d+)\s*$)", acmacs::regex::icase};
 
-static const std::regex re_CRICK_prn_2fold{"^2-fold$", acmacs::regex::icase};
-static const std::regex re_CRICK_prn_read{"^read$", acmacs::regex::icase};
-
 static const std::regex re_NIID_serum_name{R"(^\s*(?:\d+[A-Z]\s+)?)"           // [clade]
                                            R"(([A-Z][A-Z\d\s\-_\./\(\)]+)\s+)" // name with reassortant $1
                                            // R"((?:(EGG|CELL|HCK)\s+)?)"         // passage type (sometimes absent for reassortants) $2
@@ -70,18 +63,9 @@ static const std::regex re_NIID_serum_name{R"(^\s*(?:\d+[A-Z]\s+)?)"           /
 static const std::regex re_NIID_serum_passage{R"(\s*(EGG|CELL|HCK)?\s*(?:NIID)?\s*$)", acmacs::regex::icase};
 
 static const std::regex re_NIID_serum_name_fix{R"(\s*([\-/])\s*)", acmacs::regex::icase}; // remove spaces around - and /
-static const std::regex re_NIID_lab_id_label{"^\\s*NIID-ID\\s*$", acmacs::regex::icase};
-static const std::regex re_NIID_serum_name_row_non_serum_label{R"((HA\s*group))", acmacs::regex::icase};
+static const acmacs::sheet::anchored_label_t re_NIID_lab_id_label{"^\\s*NIID-ID\\s*$", acmacs::regex::icase};
 
-static const std::regex re_VIDRL_antigen_lab_id{"^(SL|VW)[0-9]{8}$", acmacs::regex::icase};
-static const std::regex re_VIDRL_antigen_date_column_title{"^\\s*Sample\\s*Date\\s*$", acmacs::regex::icase};
-static const std::regex re_VIDRL_antigen_lab_id_column_title{"^\\s*VW\\s*$", acmacs::regex::icase};
 static const std::regex re_VIDRL_serum_name{"^(?:[AB]/)?([A-Z][A-Z ]+)/?([0-9]+)(?:_.*)?$", acmacs::regex::icase}; // optional mutant info at the end
-#define pattern_VIDRL_serum_id "[AF][0-9][0-9][0-9][0-9](?:-[0-9]+D)?"
-static const std::regex re_VIDRL_serum_id{"^(" pattern_VIDRL_serum_id "|" pattern_CRICK_serum_id ")$", acmacs::regex::icase};
-static const std::regex re_VIDRL_serum_id_with_days{"^[AF][0-9][0-9][0-9][0-9]-[0-9]+D$", acmacs::regex::icase};
-
-static const std::regex re_human_who_serum{R"(^\s*(.*(HUMAN|WHO|NORMAL)|GOAT|POST? VAX)\b)", acmacs::regex::icase}; // "POST VAX" is in VIDRL H3 HI 2021
 
 #include "acmacs-base/diagnostics-pop.hh"
 
@@ -90,8 +74,13 @@ static const std::string_view LineageYamagata{"YAMAGATA"};
 
 // ----------------------------------------------------------------------
 
-std::unique_ptr<acmacs::sheet::Extractor> acmacs::sheet::v1::extractor_factory(std::shared_ptr<Sheet> sheet, Extractor::warn_if_not_found winf)
+std::unique_ptr<acmacs::sheet::Extractor> acmacs::sheet::v1::extractor_factory(std::shared_ptr<Sheet> sheet, Extractor::warn_if_not_found winf, size_t number_of_threads)
 {
+    if (is_ignored_sheet_name(sheet->name())) {
+        AD_INFO("Sheet \"{}\": ignored on request in sheet name", sheet->name());
+        return nullptr;
+    }
+
     const auto detected = acmacs::whocc_xlsx::v1::py_sheet_detect(sheet);
     try {
         std::unique_ptr<Extractor> extractor;
@@ -100,7 +89,7 @@ std::unique_ptr<acmacs::sheet::Extractor> acmacs::sheet::v1::extractor_factory(s
             return nullptr;
         }
 
-        if (sheet->number_of_rows() < nrow_t{5} || sheet->number_of_columns() < ncol_t{5}) {
+        if (sheet->number_of_rows() < minimal_number_of_rows || sheet->number_of_columns() < minimal_number_of_columns) {
             AD_INFO("Sheet \"{}\": is too small, ignored", sheet->name());
             return nullptr;
         }
@@ -150,7 +139,7 @@ std::unique_ptr<acmacs::sheet::Extractor> acmacs::sheet::v1::extractor_factory(s
         else
             throw std::exception{};
         extractor->date(detected.date);
-        extractor->preprocess(winf);
+        extractor->preprocess(winf, number_of_threads);
         return extractor;
     }
     catch (std::exception& err) {
@@ -196,10 +185,8 @@ std::string acmacs::sheet::v1::Extractor::subtype_short() const
 acmacs::sheet::v1::antigen_fields_t acmacs::sheet::v1::Extractor::antigen(size_t ag_no) const
 {
     const auto make = [this, row = antigen_rows().at(ag_no)](std::optional<ncol_t> col) -> std::string {
-        if (col.has_value()) {
-            if (const auto cell = sheet().cell(row, *col); !is_empty(cell))
-                return fmt::format("{}", cell);
-        }
+        if (col.has_value())
+            return std::string{sheet().text(row, *col)};
         return {};
     };
 
@@ -214,9 +201,11 @@ acmacs::sheet::v1::antigen_fields_t acmacs::sheet::v1::Extractor::antigen(size_t
 
 // ----------------------------------------------------------------------
 
-void acmacs::sheet::v1::Extractor::preprocess(warn_if_not_found winf)
+void acmacs::sheet::v1::Extractor::preprocess(warn_if_not_found winf, size_t number_of_threads)
 {
+    classify_cells(number_of_threads); // cell classes and titer run of each row
     find_titers(winf);
+    cell_classes_.count_rows(antigen_rows_); // column counts of all classes for the column finders below
     find_antigen_name_column(winf);
     find_antigen_date_column(winf);
     find_antigen_passage_column(winf);
@@ -228,6 +217,122 @@ void acmacs::sheet::v1::Extractor::preprocess(warn_if_not_found winf)
 
 // ----------------------------------------------------------------------
 
+static inline bool is_antigen_date(const acmacs::sheet::cell_view_t& cell)
+{
+    // VIDRL uses string values DD/MM/YYYY for antigen dates
+    return acmacs::sheet::is_date(cell) || (acmacs::sheet::is_string(cell) && date::from_string(std::get<std::string_view>(cell), date::allow_incomplete::no, date::throw_on_error::no).ok());
+}
+
+void acmacs::sheet::v1::Extractor::classify_cells(size_t number_of_threads)
+{
+    const auto& sheet = this->sheet();
+    cell_classes_ = cell_classes_t{sheet.number_of_rows(), sheet.number_of_columns()};
+    const auto& occupied = sheet.occupancy(); // materializes sheet grid before classifying threads start
+
+    struct text_cell_t
+    {
+        nrow_t row;
+        ncol_t col;
+        std::string_view text;
+    };
+
+    // titer, date and lab id are pure predicates of the cell and run in parallel bands,
+    // string cells are collected for the virus name and passage validators run afterwards in this thread
+    const auto classify_rows = [this, &sheet, &occupied](nrow_t first, nrow_t last) {
+        std::vector<text_cell_t> text_cells;
+        for (auto row = first; row < last; ++row) {
+            if (!occupied.row(row))
+                continue;
+            const auto cells = sheet.row(row);
+            column_range longest_titer_run, titer_run;
+            const auto end_titer_run = [&longest_titer_run, &titer_run] {
+                if (titer_run.valid()) {
+                    if (!longest_titer_run.valid() || longest_titer_run.length() < titer_run.length())
+                        longest_titer_run = titer_run;
+                    titer_run = column_range{};
+                }
+            };
+            for (ncol_t col{0}; col < sheet.number_of_columns(); ++col) {
+                uint8_t classes{0};
+                if (const auto cell = cells[col]; !is_empty(cell)) {
+                    if (Sheet::maybe_titer(cell))
+                        classes |= cell_classes_t::titer;
+                    if (is_antigen_date(cell))
+                        classes |= cell_classes_t::date;
+                    if (is_lab_id(cell))
+                        classes |= cell_classes_t::lab_id;
+                    cell_classes_.set(row, col, classes);
+                    if (const auto* text = std::get_if<std::string_view>(&cell); text) // numbers are neither virus names nor passages
+                        text_cells.push_back({row, col, *text});
+                }
+                if (classes & cell_classes_t::titer) {
+                    if (!titer_run.valid())
+                        titer_run.first = col;
+                    titer_run.second = col;
+                }
+                else
+                    end_titer_run();
+            }
+            end_titer_run();
+            cell_classes_.titer_run(row, longest_titer_run);
+        }
+        return text_cells;
+    };
+
+    const auto classify_text_cells = [this](const std::vector<text_cell_t>& text_cells) {
+        for (const auto& [row, col, text] : text_cells) {
+            uint8_t classes{0};
+            if (is_virus_name(text))
+                classes |= cell_classes_t::virus_name;
+            if (acmacs::virus::is_good_passage(text))
+                classes |= cell_classes_t::passage;
+            cell_classes_.add(row, col, classes);
+        }
+    };
+
+    // sheet is split into bands of rows classified in parallel, sheets converted concurrently share the threads of the caller
+    constexpr const size_t min_rows_per_band{32};
+    const size_t number_of_rows{*sheet.number_of_rows()};
+    if (number_of_threads == 0)
+        number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t number_of_bands = std::clamp(number_of_rows / min_rows_per_band, 1ul, number_of_threads);
+    const size_t band_size = (number_of_rows + number_of_bands - 1) / number_of_bands;
+    std::vector<std::future<std::vector<text_cell_t>>> bands;
+    for (size_t first = band_size; first < number_of_rows; first += band_size)
+        bands.push_back(std::async(std::launch::async, classify_rows, nrow_t{first}, nrow_t{std::min(first + band_size, number_of_rows)}));
+    classify_text_cells(classify_rows(nrow_t{0}, nrow_t{std::min(band_size, number_of_rows)}));
+    for (auto& band : bands)
+        classify_text_cells(band.get()); // rethrows exception of the band
+
+} // acmacs::sheet::v1::Extractor::classify_cells
+
+// ----------------------------------------------------------------------
+
+void acmacs::sheet::v1::cell_classes_t::count_rows(const std::vector<nrow_t>& rows)
+{
+    counts_.assign(*number_of_columns_, {});
+    tally(rows, 1);
+
+} // acmacs::sheet::v1::cell_classes_t::count_rows
+
+// ----------------------------------------------------------------------
+
+void acmacs::sheet::v1::cell_classes_t::tally(const std::vector<nrow_t>& rows, int increment)
+{
+    for (const auto row : rows) {
+        if (row >= number_of_rows_)
+            continue;
+        const auto* row_classes = &classes_[index(row, ncol_t{0})];
+        for (size_t col{0}; col < *number_of_columns_; ++col) {
+            for (auto classes = row_classes[col]; classes != 0; classes = static_cast<uint8_t>(classes & (classes - 1))) // every bit set
+                counts_[col][static_cast<size_t>(std::countr_zero(classes))] += static_cast<size_t>(increment);
+        }
+    }
+
+} // acmacs::sheet::v1::cell_classes_t::tally
+
+// ----------------------------------------------------------------------
+
 template <acmacs::sheet::NRowCol nrowcol> using number_ranges = std::vector<std::pair<nrowcol, nrowcol>>;
 
 template <acmacs::sheet::NRowCol nrowcol> inline number_ranges<nrowcol> make_ranges(const std::vector<nrowcol>& numbers)
@@ -298,10 +403,10 @@ void acmacs::sheet::v1::Extractor::check_export_possibility() const // throws Er
 
 std::string acmacs::sheet::v1::Extractor::titer(size_t ag_no, size_t sr_no) const
 {
-    const auto cell = sheet().cell(antigen_rows().at(ag_no), serum_columns().at(sr_no));
+    const auto cell = sheet().cell_view(antigen_rows().at(ag_no), serum_columns().at(sr_no));
     return std::visit(
         [&cell]<typename Content>(const Content& cont) -> std::string {
-            if constexpr (std::is_same_v<Content, std::string>)
+            if constexpr (std::is_same_v<Content, std::string_view>)
                 return ::string::remove_spaces(cont); // NIID has titers with spaces, e.g. "< 10"
             else if constexpr (std::is_same_v<Content, long>)
                 return fmt::format("{}", cont);
@@ -321,7 +426,7 @@ void acmacs::sheet::v1::Extractor::find_titers(warn_if_not_found winf)
     std::vector<std::pair<nrow_t, range<ncol_t>>> rows;
     // AD_DEBUG("Sheet {}", sheet().name());
     for (nrow_t row{0}; row < sheet().number_of_rows(); ++row) {
-        auto titers = sheet().titer_range(row);
+        auto titers = cell_classes_.titer_run(row);
         adjust_titer_range(row, titers);
         if (titers.valid() && titers.length() > 2 && titers.first > ncol_t{0} && valid_titer_row(row, titers))
             rows.emplace_back(row, std::move(titers));
@@ -344,9 +449,9 @@ void acmacs::sheet::v1::Extractor::find_titers(warn_if_not_found winf)
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::Extractor::is_virus_name(nrow_t row, ncol_t col) const
+bool acmacs::sheet::v1::Extractor::is_virus_name(std::string_view text) const
 {
-    return acmacs::virus::name::is_good(fmt::format("{}", sheet().cell(row, col)));
+    return acmacs::virus::name::is_good(text);
 
 } // acmacs::sheet::v1::Extractor::is_virus_name
 
@@ -355,14 +460,20 @@ bool acmacs::sheet::v1::Extractor::is_virus_name(nrow_t row, ncol_t col) const
 void acmacs::sheet::v1::Extractor::find_antigen_name_column(warn_if_not_found winf)
 {
     for (ncol_t col{0}; col < serum_columns()[0]; ++col) { // to the left from titers
-        if (static_cast<size_t>(ranges::count_if(antigen_rows_, [col, this](nrow_t row) { return is_virus_name(row, col); })) > (antigen_rows_.size() / 2)) {
+        if (cell_classes_.count(cell_classes_t::virus_name, col) > (antigen_rows_.size() / 2)) {
             antigen_name_column_ = col;
             break;
         }
     }
 
-    if (antigen_name_column_.has_value())
+    if (antigen_name_column_.has_value()) {
+        const auto titer_rows = antigen_rows_;
         remove_redundant_antigen_rows(winf);
+        // removed rows are not counted by the column finders (antigen rows are sorted, removing keeps order)
+        std::vector<nrow_t> removed;
+        std::set_difference(std::begin(titer_rows), std::end(titer_rows), std::begin(antigen_rows_), std::end(antigen_rows_), std::back_inserter(removed));
+        cell_classes_.uncount_rows(removed);
+    }
     else
         AD_WARNING(winf == warn_if_not_found::yes, "Antigen name column not found");
 
@@ -387,7 +498,7 @@ void acmacs::sheet::v1::Extractor::remove_redundant_antigen_rows(warn_if_not_fou
     const auto are_titers_increasing_numers = [this, cell_is_number_equal_to](nrow_t row) {
         long num{1};
         for (const auto col : serum_columns_) {
-            if (!cell_is_number_equal_to(sheet().cell(row, col), num))
+            if (!cell_is_number_equal_to(sheet().cell_view(row, col), num))
                 return false;
             ++num;
         }
@@ -398,9 +509,9 @@ void acmacs::sheet::v1::Extractor::remove_redundant_antigen_rows(warn_if_not_fou
         AD_LOG(acmacs::log::xlsx, "Antigen name column: {}", *antigen_name_column_);
         // remote antigen rows that have no name
         ranges::actions::remove_if(antigen_rows_, [this, are_titers_increasing_numers, winf](nrow_t row) {
-            const auto no_name = !is_virus_name(row, *antigen_name_column_);
+            const auto no_name = !cell_classes_.is(cell_classes_t::virus_name, row, *antigen_name_column_);
             if (no_name && !are_titers_increasing_numers(row))
-                AD_WARNING(winf == warn_if_not_found::yes, "row {} has titers but no name: {}", row, sheet().cell(row, *antigen_name_column_));
+                AD_WARNING(winf == warn_if_not_found::yes, "row {} has titers but no name: {}", row, sheet().cell_view(row, *antigen_name_column_));
             return no_name;
         });
     }
@@ -411,31 +522,27 @@ void acmacs::sheet::v1::Extractor::remove_redundant_antigen_rows(warn_if_not_fou
 
 // ----------------------------------------------------------------------
 
-template <typename F> inline std::optional<acmacs::sheet::ncol_t> find_column(const acmacs::sheet::Sheet& sheet, const std::vector<acmacs::sheet::nrow_t>& rows, F valid_cell)
+// column having the most cells of the class among the counted antigen rows, the leftmost one if there are several
+inline std::optional<acmacs::sheet::ncol_t> find_column(const acmacs::sheet::Sheet& sheet, const acmacs::sheet::cell_classes_t& cell_classes, acmacs::sheet::cell_classes_t::class_t cls)
 {
     using namespace acmacs::sheet;
 
-    std::vector<std::tuple<ncol_t, ssize_t>> number_per_column;
+    std::optional<ncol_t> found;
+    size_t found_number{0};
     for (ncol_t col{0}; col < sheet.number_of_columns(); ++col) {
-        if (const auto number = ranges::count_if(rows, [col, &valid_cell, &sheet](nrow_t row) { return valid_cell(sheet.cell(row, col)); }); number > 0)
-            number_per_column.emplace_back(col, number);
+        if (const auto number = cell_classes.count(cls, col); number > found_number) {
+            found = col;
+            found_number = number;
+        }
     }
-    if (!number_per_column.empty())
-        return std::get<ncol_t>(*ranges::max_element(number_per_column, [](const auto& e1, const auto& e2) { return std::get<ssize_t>(e1) < std::get<ssize_t>(e2); }));
-    else
-        return std::nullopt;
+    return found;
 }
 
 // ----------------------------------------------------------------------
 
 void acmacs::sheet::v1::Extractor::find_antigen_date_column(warn_if_not_found winf)
 {
-    const auto is_date = [](const auto& cell) {
-        // VIDRL uses string values DD/MM/YYYY for antigen dates
-        return acmacs::sheet::is_date(cell) || (acmacs::sheet::is_string(cell) && date::from_string(fmt::format("{}", cell), date::allow_incomplete::no, date::throw_on_error::no).ok());
-    };
-
-    antigen_date_column_ = ::find_column(sheet(), antigen_rows_, is_date);
+    antigen_date_column_ = ::find_column(sheet(), cell_classes_, cell_classes_t::date);
     if (antigen_date_column_.has_value())
         AD_LOG(acmacs::log::xlsx, "Antigen date column: {}", *antigen_date_column_);
     else
@@ -455,7 +562,7 @@ void acmacs::sheet::v1::Extractor::find_antigen_date_column(warn_if_not_found wi
 
 void acmacs::sheet::v1::Extractor::find_antigen_passage_column(warn_if_not_found winf)
 {
-    antigen_passage_column_ = ::find_column(sheet(), antigen_rows_, [](const auto& cell) { return acmacs::virus::is_good_passage(fmt::format("{}", cell)); });
+    antigen_passage_column_ = ::find_column(sheet(), cell_classes_, cell_classes_t::passage);
     if (antigen_passage_column_.has_value())
         AD_LOG(acmacs::log::xlsx, "Antigen passage column: {}", *antigen_passage_column_);
     else
@@ -467,7 +574,7 @@ void acmacs::sheet::v1::Extractor::find_antigen_passage_column(warn_if_not_found
 
 void acmacs::sheet::v1::Extractor::find_antigen_lab_id_column(warn_if_not_found winf)
 {
-    antigen_lab_id_column_ = ::find_column(sheet(), antigen_rows_, [this](const auto& cell) { return is_lab_id(cell); });
+    antigen_lab_id_column_ = ::find_column(sheet(), cell_classes_, cell_classes_t::lab_id);
     if (antigen_lab_id_column_.has_value())
         AD_LOG(acmacs::log::xlsx, "Antigen lab_id column: {}", *antigen_lab_id_column_);
     else
@@ -477,38 +584,65 @@ void acmacs::sheet::v1::Extractor::find_antigen_lab_id_column(warn_if_not_found
 
 // ----------------------------------------------------------------------
 
-std::optional<acmacs::sheet::v1::nrow_t> acmacs::sheet::v1::Extractor::find_serum_row(const std::regex& re, std::string_view row_name, warn_if_not_found winf, std::optional<nrow_t> ignore) const
+std::optional<acmacs::sheet::v1::nrow_t> acmacs::sheet::v1::Extractor::find_serum_row(text_matcher_t matcher, std::string_view row_name, warn_if_not_found winf) const
 {
-    std::optional<nrow_t> found;
-    for (nrow_t row{1}; row < antigen_rows()[0]; ++row) {
-        if (!ignore || row != *ignore) {
-            if (const auto num_columns = static_cast<size_t>(ranges::count_if(serum_columns(), [row, this, re](ncol_t col) { return sheet().matches(re, row, col); }));
-                num_columns >= (number_of_sera() / 2)) {
-                found = row;
-                break;
-            }
-            else if (num_columns > 0) {
-                if (row_name == "id")
-                    AD_WARNING("find_serum_row {} (too few columns): row:{} columns:{} number of sera: {}", row_name, row, num_columns, number_of_sera());
+    return find_serum_rows_matching({serum_row_pattern_t{.matcher = matcher, .row_name = row_name}}, winf).front();
+
+} // acmacs::sheet::v1::Extractor::find_serum_row
+
+// ----------------------------------------------------------------------
+
+std::vector<std::optional<acmacs::sheet::v1::nrow_t>> acmacs::sheet::v1::Extractor::find_serum_rows_matching(const std::vector<serum_row_pattern_t>& patterns, warn_if_not_found winf) const
+{
+    // number of matching serum columns for each row above antigens and each pattern, text of a cell is made once for all patterns
+    const nrow_t last_row{antigen_rows().empty() ? 0ul : *antigen_rows()[0]};
+    std::vector<size_t> matches(*last_row * patterns.size(), 0); // [row * patterns.size() + pattern_no]
+    for (nrow_t row{1}; row < last_row; ++row) {
+        auto* row_matches = &matches[*row * patterns.size()];
+        for (const auto col : serum_columns()) {
+            const auto text = sheet().text(row, col); // non-string cells are matched against their text, CDC id is a number in CDC tables
+            for (size_t pattern_no{0}; pattern_no < patterns.size(); ++pattern_no) {
+                if (patterns[pattern_no].matcher(text))
+                    ++row_matches[pattern_no];
             }
         }
     }
 
-    if (found.has_value())
-        AD_LOG(acmacs::log::xlsx, "[{}] Serum {} row: {}", lab(), row_name, *found);
-    else
-        AD_WARNING(winf == warn_if_not_found::yes, "[{}] Serum {} row not found", lab(), row_name);
+    std::vector<std::optional<nrow_t>> found(patterns.size());
+    for (size_t pattern_no{0}; pattern_no < patterns.size(); ++pattern_no) { // in order, ignore_row_of refers to a preceding pattern
+        const auto& pattern = patterns[pattern_no];
+        const auto min_columns = pattern.min_columns > 0 ? pattern.min_columns : (number_of_sera() / 2);
+        const auto ignore = pattern.ignore_row_of.has_value() ? found.at(*pattern.ignore_row_of) : std::nullopt;
+        fmt::memory_buffer report;
+        for (nrow_t row{1}; row < last_row; ++row) {
+            if (!ignore || row != *ignore) {
+                if (const auto num_columns = matches[*row * patterns.size() + pattern_no]; num_columns >= min_columns) {
+                    found[pattern_no] = row;
+                    break;
+                }
+                else if (num_columns > 0) {
+                    if (pattern.row_name == "id")
+                        AD_WARNING("find_serum_row {} (too few columns): row:{} columns:{} number of sera: {}", pattern.row_name, row, num_columns, number_of_sera());
+                    fmt::format_to_mb(report, "    row:{} columns:{}\n", row, num_columns);
+                }
+            }
+        }
+
+        if (found[pattern_no].has_value())
+            AD_LOG(acmacs::log::xlsx, "[{}] Serum {} row: {}", lab(), pattern.row_name, *found[pattern_no]);
+        else
+            AD_WARNING(winf == warn_if_not_found::yes, "[{}] Serum {} row not found (number of sera: {})\n{}", lab(), pattern.row_name, number_of_sera(), fmt::to_string(report));
+    }
     return found;
 
-} // acmacs::sheet::v1::Extractor::find_serum_row
+} // acmacs::sheet::v1::Extractor::find_serum_rows_matching
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::Extractor::is_control_serum_cell(const cell_t& cell) const
+bool acmacs::sheet::v1::Extractor::is_control_serum_cell(const cell_view_t& cell) const
 {
     if (is_string(cell)) {
-        const auto text = fmt::format("{}", cell);
-        if (std::regex_search(text, re_human_who_serum))
+        if (const auto text = std::get<std::string_view>(cell); anchor::human_who_serum(text))
             return true;
     }
     return false;
@@ -594,9 +728,9 @@ std::string acmacs::sheet::v1::ExtractorCDC::titer(size_t ag_no, size_t sr_no) c
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::ExtractorCDC::is_lab_id(const cell_t& cell) const
+bool acmacs::sheet::v1::ExtractorCDC::is_lab_id(const cell_view_t& cell) const
 {
-    return sheet().matches(re_CDC_antigen_lab_id, cell);
+    return sheet().matches(anchor::CDC_antigen_lab_id, cell);
 
 } // acmacs::sheet::v1::ExtractorCDC::is_lab_id
 
@@ -607,8 +741,8 @@ void acmacs::sheet::v1::ExtractorCDC::remove_redundant_antigen_rows(warn_if_not_
     if (antigen_name_column_.has_value()) {
         // remove CONTROL antigen rows, e.g. "INFLUENZA B CONTROL AG, YAM LINEAGE"
         ranges::actions::remove_if(antigen_rows_, [this](nrow_t row) {
-            if (sheet().matches(re_CDC_antigen_control, row, *antigen_name_column_)) {
-                // AD_DEBUG("CONTROL antigen removed: {}", row, sheet().cell(row, *antigen_name_column_));
+            if (sheet().matches(anchor::CDC_antigen_control, row, *antigen_name_column_)) {
+                // AD_DEBUG("CONTROL antigen removed: {}", row, sheet().cell_view(row, *antigen_name_column_));
                 return true;
             }
             else
@@ -622,7 +756,7 @@ void acmacs::sheet::v1::ExtractorCDC::remove_redundant_antigen_rows(warn_if_not_
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::ExtractorCDC::serum_index_matches(const cell_t& at_row, const cell_t& at_column) const
+bool acmacs::sheet::v1::ExtractorCDC::serum_index_matches(const cell_view_t& at_row, const cell_view_t& at_column) const
 {
     if (is_empty(at_row) || is_empty(at_column))
         return false;
@@ -635,9 +769,10 @@ bool acmacs::sheet::v1::ExtractorCDC::serum_index_matches(const cell_t& at_row,
 acmacs::sheet::v1::nrow_t acmacs::sheet::v1::ExtractorCDC::find_serum_row_by_col(ncol_t col) const
 {
     if (serum_index_row_.has_value() && serum_index_column_.has_value()) {
-        if (const auto serum_index = sheet().cell(*serum_index_row_, col); !is_empty(serum_index)) {
+        if (const auto serum_index = sheet().cell_view(*serum_index_row_, col); !is_empty(serum_index)) {
+            const auto index_cells = sheet().column(*serum_index_column_);
             for (nrow_t row{serum_rows_[0]}; row < sheet().number_of_rows(); ++row) {
-                if (const auto index_cell = sheet().cell(row, *serum_index_column_); serum_index_matches(serum_index, index_cell))
+                if (serum_index_matches(serum_index, index_cells[row]))
                     return row;
             }
         }
@@ -654,10 +789,8 @@ acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorCDC::serum(size_t
     if (const auto row = find_serum_row_by_col(serum_columns().at(sr_no)); valid(row)) {
 
         const auto make = [this, row](std::optional<ncol_t> col) -> std::string {
-            if (col.has_value()) {
-                if (const auto cell = sheet().cell(row, *col); !is_empty(cell))
-                    return fmt::format("{}", cell);
-            }
+            if (col.has_value())
+                return std::string{sheet().text(row, *col)};
             return {};
         };
 
@@ -674,7 +807,7 @@ acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorCDC::serum(size_t
                 .species = make(serum_species_column_),               //
                 .conc = make(serum_conc_column_),                     //
                 .dilut = make(serum_dilut_column_),                   //
-                .boosted = serum_boosted_column_.has_value() && !is_empty(sheet().cell(row, *serum_boosted_column_)) && fmt::format("{}", sheet().cell(row, *serum_boosted_column_))[0] == 'Y'};
+                .boosted = serum_boosted_column_.has_value() && !is_empty(sheet().cell_view(row, *serum_boosted_column_)) && sheet().text(row, *serum_boosted_column_)[0] == 'Y'};
     }
     else
         return {};
@@ -685,19 +818,19 @@ acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorCDC::serum(size_t
 
 void acmacs::sheet::v1::ExtractorCDC::find_serum_rows(warn_if_not_found winf)
 {
-    find_serum_index_row(winf, re_CDC_serum_index);
-    find_serum_name_column(winf, re_CDC_serum_index);
+    find_serum_index_row(winf, anchor::CDC_serum_index);
+    find_serum_name_column(winf, anchor::CDC_serum_index);
     find_serum_columns(winf);
 
 } // acmacs::sheet::v1::ExtractorCDC::find_serum_rows
 
 // ----------------------------------------------------------------------
 
-void acmacs::sheet::v1::ExtractorCDC::find_serum_index_row(warn_if_not_found winf, const std::regex& re_serum_index)
+void acmacs::sheet::v1::ExtractorCDC::find_serum_index_row(warn_if_not_found winf, text_matcher_t serum_index)
 {
     fmt::memory_buffer report;
     for (nrow_t row{1}; row < antigen_rows()[0]; ++row) {
-        if (const size_t matches = static_cast<size_t>(ranges::count_if(serum_columns(), [row, re_serum_index, this](ncol_t col) { return sheet().matches(re_serum_index, row, col); }));
+        if (const size_t matches = static_cast<size_t>(ranges::count_if(serum_columns(), [cells = sheet().row(row), serum_index](ncol_t col) { return Sheet::matches(serum_index, cells[col]); }));
             matches == number_of_sera()) {
             serum_index_row_ = row;
             break;
@@ -715,12 +848,12 @@ void acmacs::sheet::v1::ExtractorCDC::find_serum_index_row(warn_if_not_found win
 
 // ----------------------------------------------------------------------
 
-void acmacs::sheet::v1::ExtractorCDC::find_serum_name_column(warn_if_not_found winf, const std::regex& re_serum_index)
+void acmacs::sheet::v1::ExtractorCDC::find_serum_name_column(warn_if_not_found winf, text_matcher_t serum_index)
 {
     for (ncol_t col{0}; col < ncol_t{5} && !serum_name_column_; ++col) {
         serum_rows_.clear();
         for (nrow_t row{antigen_rows().back() + nrow_t{1}}; row < sheet().number_of_rows(); ++row) {
-            if (is_virus_name(row, col))
+            if (cell_classes_.is(cell_classes_t::virus_name, row, col))
                 serum_rows_.push_back(row);
         }
         if (serum_rows_.size() > (serum_columns().size() / 2))
@@ -737,9 +870,9 @@ void acmacs::sheet::v1::ExtractorCDC::find_serum_name_column(warn_if_not_found w
     if (serum_name_column_ > ncol_t{0}) {
         serum_index_column_ = *serum_name_column_ - ncol_t{1};
         for (const nrow_t row : serum_rows_) {
-            if (!sheet().matches(re_serum_index, row, *serum_index_column_))
-                AD_WARNING("{} unrecognized serum index at {}{}: \"{}\" for serum \"{}\"", extractor_name(), row, serum_index_column_, sheet().cell(row, *serum_index_column_),
-                           sheet().cell(row, *serum_name_column_));
+            if (!sheet().matches(serum_index, row, *serum_index_column_))
+                AD_WARNING("{} unrecognized serum index at {}{}: \"{}\" for serum \"{}\"", extractor_name(), row, serum_index_column_, sheet().cell_view(row, *serum_index_column_),
+                           sheet().cell_view(row, *serum_name_column_));
         }
     }
     else
@@ -777,7 +910,7 @@ void acmacs::sheet::v1::ExtractorCDC::find_serum_columns(warn_if_not_found /*win
 
 // ----------------------------------------------------------------------
 
-void acmacs::sheet::v1::ExtractorCDC::find_serum_column_label(const std::regex& re, std::optional<ncol_t>& col, std::string_view label_name)
+void acmacs::sheet::v1::ExtractorCDC::find_serum_column_label(const anchored_label_t& re, std::optional<ncol_t>& col, std::string_view label_name)
 {
     if (const auto matches = sheet().grep(re, {serum_rows_[0] - nrow_t{1}, *serum_name_column_ + ncol_t{1}}, {serum_rows_[0], sheet().number_of_columns()}); matches.size() == 1)
         col = matches[0].col;
@@ -788,7 +921,7 @@ void acmacs::sheet::v1::ExtractorCDC::find_serum_column_label(const std::regex&
 
 // ----------------------------------------------------------------------
 
-void acmacs::sheet::v1::ExtractorCDC::find_serum_column_label(const std::regex& re1, const std::regex& re2, std::optional<ncol_t>& col, std::string_view label_name)
+void acmacs::sheet::v1::ExtractorCDC::find_serum_column_label(const anchored_label_t& re1, const anchored_label_t& re2, std::optional<ncol_t>& col, std::string_view label_name)
 {
     const cell_addr_t min{serum_rows_[0] - nrow_t{2}, *serum_name_column_ + ncol_t{1}}, max{serum_rows_[0], sheet().number_of_columns()};
     if (const auto matches = sheet().grepv(re1, re2, min, max); matches.size() == 1)
@@ -816,7 +949,7 @@ void acmacs::sheet::v1::ExtractorCDC::exclude_control_sera(warn_if_not_found /*w
     if (serum_index_row_.has_value() && serum_index_column_.has_value() && serum_name_column_.has_value()) {
         const auto exclude = [this](ncol_t col) {
             if (const auto row = find_serum_row_by_col(col); valid(row)) {
-                if (const auto cell = sheet().cell(row, *serum_name_column_); is_control_serum_cell(cell)) {
+                if (const auto cell = sheet().cell_view(row, *serum_name_column_); is_control_serum_cell(cell)) {
                     AD_LOG(acmacs::log::xlsx, "[CDC] serum excluded (HUMAN or WHO or NORMAL serum): \"{}\"", cell);
                     return true;
                 }
@@ -837,9 +970,9 @@ void acmacs::sheet::v1::ExtractorCDC::exclude_control_sera(warn_if_not_found /*w
 void acmacs::sheet::v1::ExtractorCDC::adjust_titer_range(nrow_t row, column_range& cr)
 {
     if (cr.valid()) {
-        while (cr.second >= cr.first && !sheet().grep(re_CDC_titer_label, {nrow_t{0}, cr.second}, {row, cr.second + ncol_t{1}}).empty()) // ignore TITER and BACK TITER columns
+        while (cr.second >= cr.first && !sheet().grep(anchor::CDC_titer_label, {nrow_t{0}, cr.second}, {row, cr.second + ncol_t{1}}).empty()) // ignore TITER and BACK TITER columns
             --cr.second;
-        if (cr.second >= cr.first && !sheet().grep(re_CDC_ha_group_label, {nrow_t{0}, cr.first}, {row, cr.first + ncol_t{1}}).empty()) // ignore HA GROUP looking like titer
+        if (cr.second >= cr.first && !sheet().grep(anchor::CDC_ha_group_label, {nrow_t{0}, cr.first}, {row, cr.first + ncol_t{1}}).empty()) // ignore HA GROUP looking like titer
             ++cr.first;
     }
 
@@ -891,7 +1024,7 @@ acmacs::sheet::v1::ExtractorAc21::ExtractorAc21(std::shared_ptr<Sheet> a_sheet)
 
 // ----------------------------------------------------------------------
 
-// bool acmacs::sheet::v1::ExtractorAc21::is_lab_id(const cell_t& cell) const
+// bool acmacs::sheet::v1::ExtractorAc21::is_lab_id(const cell_view_t& cell) const
 // {
 //     return true;
 
@@ -899,7 +1032,7 @@ acmacs::sheet::v1::ExtractorAc21::ExtractorAc21(std::shared_ptr<Sheet> a_sheet)
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::ExtractorAc21::serum_index_matches(const cell_t& at_row, const cell_t& at_column) const
+bool acmacs::sheet::v1::ExtractorAc21::serum_index_matches(const cell_view_t& at_row, const cell_view_t& at_column) const
 {
     return !is_empty(at_row) && fmt::format("{}", at_row) == fmt::format("{}", at_column);
 
@@ -911,7 +1044,7 @@ void acmacs::sheet::v1::ExtractorAc21::find_antigen_lab_id_column(warn_if_not_fo
 {
     if (const auto found = sheet().grep(re_AC21_ID_label, {nrow_t{5}, ncol_t{1}}, {antigen_rows_.front(), sheet().number_of_columns()}); !found.empty()) {
         for (const auto& cell_match : found) {
-            if (fmt::format("{}", sheet().cell(cell_match.row - nrow_t{1}, cell_match.col)) == "Strain") {
+            if (sheet().text(cell_match.row - nrow_t{1}, cell_match.col) == "Strain") {
                 antigen_lab_id_column_ = cell_match.col;
                 break;
             }
@@ -926,8 +1059,8 @@ void acmacs::sheet::v1::ExtractorAc21::find_antigen_lab_id_column(warn_if_not_fo
 
 void acmacs::sheet::v1::ExtractorAc21::find_serum_rows(warn_if_not_found winf)
 {
-    find_serum_index_row(winf, re_AC21_serum_index);
-    find_serum_name_column(winf, re_AC21_serum_index);
+    find_serum_index_row(winf, anchor::AC21_serum_index);
+    find_serum_name_column(winf, anchor::AC21_serum_index);
     find_serum_columns(winf);
 
 } // acmacs::sheet::v1::ExtractorAc21::find_serum_rows
@@ -946,10 +1079,8 @@ void acmacs::sheet::v1::ExtractorAc21::find_serum_columns(warn_if_not_found /*wi
 acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorWithSerumRowsAbove::serum(size_t sr_no) const
 {
     const auto make = [this, col = serum_columns().at(sr_no)](std::optional<nrow_t> row) -> std::string {
-        if (row.has_value()) {
-            if (const auto cell = sheet().cell(*row, col); !is_empty(cell))
-                return fmt::format("{}", cell);
-        }
+        if (row.has_value())
+            return std::string{sheet().text(*row, col)};
         return {};
     };
 
@@ -966,7 +1097,7 @@ acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorWithSerumRowsAbove
 void acmacs::sheet::v1::ExtractorWithSerumRowsAbove::exclude_control_sera(warn_if_not_found /*winf*/)
 {
     ranges::actions::remove_if(serum_columns_, [this](ncol_t col) {
-        if ((serum_name_row_.has_value() && is_control_serum_cell(sheet().cell(*serum_name_row_, col))) || (serum_id_row_.has_value() && is_control_serum_cell(sheet().cell(*serum_id_row_, col))) || (serum_passage_row_.has_value() && is_control_serum_cell(sheet().cell(*serum_passage_row_, col)))) {
+        if ((serum_name_row_.has_value() && is_control_serum_cell(sheet().cell_view(*serum_name_row_, col))) || (serum_id_row_.has_value() && is_control_serum_cell(sheet().cell_view(*serum_id_row_, col))) || (serum_passage_row_.has_value() && is_control_serum_cell(sheet().cell_view(*serum_passage_row_, col)))) {
             AD_LOG(acmacs::log::xlsx, "[{}] serum column {} excluded: HUMAN or WHO or NORMAL serum", lab(), col);
             return true;
         }
@@ -1046,48 +1177,42 @@ acmacs::sheet::v1::ExtractorCrick::ExtractorCrick(std::shared_ptr<Sheet> a_sheet
 
 void acmacs::sheet::v1::ExtractorCrick::find_serum_rows(warn_if_not_found winf)
 {
-    find_serum_name_rows(winf);
-    find_serum_passage_row(re_serum_passage, winf);
-    find_serum_id_row(re_CRICK_serum_id, winf);
+    const auto rows = find_serum_rows_matching(
+        {
+            serum_row_pattern_t{.matcher = anchor::CRICK_serum_name_1, .row_name = "name 1", .min_columns = number_of_sera() / 3 * 2 + 1},
+            serum_row_pattern_t{.matcher = anchor::serum_passage, .row_name = "passage"},
+            serum_row_pattern_t{.matcher = anchor::CRICK_serum_id, .row_name = "id"},
+        },
+        winf);
+    serum_name_1_row_ = rows[0];
+    serum_passage_row_ = rows[1];
+    serum_id_row_ = rows[2];
+    find_serum_name_2_row(winf);
     find_serum_less_than_substitutions(winf);
 
 } // acmacs::sheet::v1::ExtractorCrick::find_serum_rows
 
-
 // ======================================================================
 
-void acmacs::sheet::v1::ExtractorCrick::find_serum_name_rows(warn_if_not_found winf)
+void acmacs::sheet::v1::ExtractorCrick::find_serum_name_2_row(warn_if_not_found winf)
 {
-    fmt::memory_buffer report;
-    const auto number_of_sera_threshold = number_of_sera() / 3 * 2;
-    for (nrow_t row{1}; row < antigen_rows()[0]; ++row) {
-        if (const size_t matches = static_cast<size_t>(ranges::count_if(serum_columns(), [row, this](ncol_t col) { return sheet().matches(re_CRICK_serum_name_1, row, col); }));
-            matches > number_of_sera_threshold) {
-            serum_name_1_row_ = row;
-            break;
-        }
-        else if (matches)
-            fmt::format_to_mb(report, "    re_CRICK_serum_name_1 row:{} matches:{}\n", row, matches);
+    // second part of the serum name is right below the first part
+    if (serum_name_1_row_.has_value()) {
+        const auto row = *serum_name_1_row_ + nrow_t{1};
+        const auto number_of_sera_threshold = number_of_sera() / 3 * 2;
+        if (const auto matches = static_cast<size_t>(ranges::count_if(serum_columns(), [cells = sheet().row(row)](ncol_t col) { return Sheet::matches(anchor::CRICK_serum_name_2, cells[col]); }));
+            matches > number_of_sera_threshold)
+            serum_name_2_row_ = row;
+        else
+            AD_DEBUG("CRICK_serum_name_2 {}: {}", row, matches);
     }
 
-    if (serum_name_1_row_.has_value())
-        AD_LOG(acmacs::log::xlsx, "[Crick]: Serum name row 1: {}", serum_name_1_row_);
-    else
-        AD_WARNING(winf == warn_if_not_found::yes, "[Crick]: No serum name row 1 found (number of sera: {})\n{}", number_of_sera(), fmt::to_string(report));
-
-    if (serum_name_1_row_.has_value() &&
-        static_cast<size_t>(ranges::count_if(serum_columns(), [this](ncol_t col) { return sheet().matches(re_CRICK_serum_name_2, *serum_name_1_row_ + nrow_t{1}, col); })) > number_of_sera_threshold)
-        serum_name_2_row_ = *serum_name_1_row_ + nrow_t{1};
-    else
-        AD_DEBUG("re_CRICK_serum_name_2 {}: {}", *serum_name_1_row_ + nrow_t{1},
-                 static_cast<size_t>(ranges::count_if(serum_columns(), [this](ncol_t col) { return sheet().matches(re_CRICK_serum_name_2, *serum_name_1_row_ + nrow_t{1}, col); })));
-
     if (serum_name_2_row_.has_value())
         AD_LOG(acmacs::log::xlsx, "[Crick]: Serum name row 2: {}", serum_name_2_row_);
     else
         AD_WARNING(winf == warn_if_not_found::yes, "[Crick]: No serum name row 2 found");
 
-} // acmacs::sheet::v1::ExtractorCrick::find_serum_name_rows
+} // acmacs::sheet::v1::ExtractorCrick::find_serum_name_2_row
 
 // ----------------------------------------------------------------------
 
@@ -1096,11 +1221,11 @@ void acmacs::sheet::v1::ExtractorCrick::find_serum_less_than_substitutions(warn_
     if (!antigen_rows_.empty()) {
         if (const auto found = sheet().grep(re_CRICK_less_than, {antigen_rows_.back(), ncol_t{1}}, {sheet().number_of_rows(), ncol_t{2}}); !found.empty()) {
             for (const auto& cell_match : found)
-                footnote_index_subst_.emplace_not_replace(string::strip(fmt::format("{}", sheet().cell(cell_match.row, cell_match.col - ncol_t{1}))), cell_match.matches[1]);
+                footnote_index_subst_.emplace_not_replace(string::strip(sheet().text(cell_match.row, cell_match.col - ncol_t{1})), cell_match.matches[1]);
         }
         else if (const auto found2 = sheet().grep(re_CRICK_less_than_multi, {antigen_rows_.back(), ncol_t{1}}, {sheet().number_of_rows(), ncol_t{2}}); !found2.empty()) {
-            // AD_DEBUG("[Crick]: less than subst (multi): {}", sheet().cell(found2[0].row, found2[0].col));
-            const auto cell = fmt::format("{}", sheet().cell(found2[0].row, found2[0].col)); // do not move inside split below, cannot survive within loop
+            // AD_DEBUG("[Crick]: less than subst (multi): {}", sheet().cell_view(found2[0].row, found2[0].col));
+            const auto cell = sheet().text(found2[0].row, found2[0].col);
             const auto split = [&cell]() {
                 if (cell.find(";") != std::string::npos)
                     return acmacs::string::split(cell, ";");
@@ -1125,8 +1250,8 @@ void acmacs::sheet::v1::ExtractorCrick::find_serum_less_than_substitutions(warn_
             serum_less_than_substitutions_.resize(number_of_sera(), "<");
             if (serum_id_row_.has_value()) {
                 for (const auto sr_no : range_from_0_to(number_of_sera())) {
-                    const auto cell = sheet().cell(*serum_id_row_, serum_columns().at(sr_no));
-                    if (std::smatch match; sheet().matches(re_CRICK_serum_id, match, cell)) {
+                    const auto cell = sheet().cell_view(*serum_id_row_, serum_columns().at(sr_no));
+                    if (std::cmatch match; sheet().matches(re_CRICK_serum_id, match, cell)) {
                         serum_less_than_substitutions_[sr_no] = footnote_index_subst_.get_or(match.str(2), std::string{"<"});
                         AD_LOG(acmacs::log::xlsx, "[Crick]:     SR: {} replacing \"<\" with \"{}\" (serum id footnote match: \"{}\")", sr_no, serum_less_than_substitutions_[sr_no], match.str(2));
                     }
@@ -1143,7 +1268,7 @@ acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorCrick::serum(size_
 {
     auto serum = ExtractorWithSerumRowsAbove::serum(sr_no);
     if (serum_name_1_row_ && serum_name_2_row_) {
-        const auto n1{fmt::format("{}", sheet().cell(*serum_name_1_row_, serum_columns().at(sr_no)))}, n2{fmt::format("{}", sheet().cell(*serum_name_2_row_, serum_columns().at(sr_no)))};
+        const auto n1{sheet().text(*serum_name_1_row_, serum_columns().at(sr_no))}, n2{sheet().text(*serum_name_2_row_, serum_columns().at(sr_no))};
         if (n1.size() > 2 && n1[1] == '/')
             serum.name = fmt::format("{}/{}", n1, n2);
         else
@@ -1230,8 +1355,9 @@ void acmacs::sheet::v1::ExtractorCrickPRN::find_serum_rows(warn_if_not_found win
 void acmacs::sheet::v1::ExtractorCrickPRN::find_two_fold_read_row()
 {
     for (nrow_t row{1}; row < antigen_rows()[0]; ++row) {
-        const size_t two_fold_matches = static_cast<size_t>(ranges::count_if(serum_columns(), [row, this](ncol_t col) { return sheet().matches(re_CRICK_prn_2fold, row, col); }));
-        const size_t read_matches = static_cast<size_t>(ranges::count_if(serum_columns(), [row, this](ncol_t col) { return sheet().matches(re_CRICK_prn_read, row, col); }));
+        const auto cells = sheet().row(row);
+        const size_t two_fold_matches = static_cast<size_t>(ranges::count_if(serum_columns(), [&cells](ncol_t col) { return Sheet::matches(anchor::CRICK_prn_2fold, cells[col]); }));
+        const size_t read_matches = static_cast<size_t>(ranges::count_if(serum_columns(), [&cells](ncol_t col) { return Sheet::matches(anchor::CRICK_prn_read, cells[col]); }));
         if (two_fold_matches == (serum_columns().size() / 2) && two_fold_matches == read_matches) {
             two_fold_read_row_ = row;
             break;
@@ -1264,7 +1390,7 @@ std::string acmacs::sheet::v1::ExtractorCrickPRN::titer(size_t ag_no, size_t sr_
     using namespace std::string_view_literals;
     if (two_fold_read_row_.has_value()) {
         const auto left_col = serum_columns().at(sr_no);
-        const auto two_fold_col = sheet().matches(re_CRICK_prn_2fold, *two_fold_read_row_, left_col) ? left_col : ncol_t{left_col + ncol_t{1}};
+        const auto two_fold_col = sheet().matches(anchor::CRICK_prn_2fold, *two_fold_read_row_, left_col) ? left_col : ncol_t{left_col + ncol_t{1}};
         const auto read_col = two_fold_col == left_col ? ncol_t{left_col + ncol_t{1}} : left_col;
 
         // interpretaion of < in the Crick PRN tables is not quite
@@ -1274,8 +1400,8 @@ std::string acmacs::sheet::v1::ExtractorCrickPRN::titer(size_t ag_no, size_t sr_
         const auto extract = [](const auto& cell) {
             return std::visit(
                 [&cell]<typename Content>(const Content& cont) {
-                    if constexpr (std::is_same_v<Content, std::string>)
-                        return cont;
+                    if constexpr (std::is_same_v<Content, std::string_view>)
+                        return std::string{cont};
                     else if constexpr (std::is_same_v<Content, long>)
                         return fmt::format("{}", cont);
                     else if constexpr (std::is_same_v<Content, double>)
@@ -1286,7 +1412,7 @@ std::string acmacs::sheet::v1::ExtractorCrickPRN::titer(size_t ag_no, size_t sr_
                 cell);
         };
 
-        return fmt::format("{}/{}", extract(sheet().cell(antigen_rows().at(ag_no), two_fold_col)), extract(sheet().cell(antigen_rows().at(ag_no), read_col)));
+        return fmt::format("{}/{}", extract(sheet().cell_view(antigen_rows().at(ag_no), two_fold_col)), extract(sheet().cell_view(antigen_rows().at(ag_no), read_col)));
     }
     else
         return ExtractorCrick::titer(ag_no, sr_no);
@@ -1323,7 +1449,7 @@ void acmacs::sheet::v1::ExtractorNIID::find_antigen_lab_id_column(warn_if_not_fo
 acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorNIID::serum(size_t sr_no) const
 {
     if (serum_name_row().has_value()) {
-        const auto serum_designation = fmt::format("{}", sheet().cell(*serum_name_row(), serum_columns().at(sr_no)));
+        const std::string serum_designation{sheet().text(*serum_name_row(), serum_columns().at(sr_no))};
         if (std::smatch match; std::regex_search(serum_designation, match, re_NIID_serum_name)) {
             auto name = ::string::replace(::string::upper(match.str(1)), '\n', ' ');
             name = std::regex_replace(name, re_NIID_serum_name_fix, "$1");
@@ -1361,20 +1487,19 @@ std::string acmacs::sheet::v1::ExtractorNIID::titer(size_t ag_no, size_t sr_no)
 
 void acmacs::sheet::v1::ExtractorNIID::find_serum_rows(warn_if_not_found winf)
 {
-    serum_name_row_ = find_serum_row(re_NIID_serum_name, "name", winf);
+    serum_name_row_ = find_serum_row(anchor::NIID_serum_name, "name", winf);
 
 } // acmacs::sheet::v1::ExtractorNIID::find_serum_rows
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::ExtractorNIID::is_control_serum_cell(const cell_t& cell) const
+bool acmacs::sheet::v1::ExtractorNIID::is_control_serum_cell(const cell_view_t& cell) const
 {
     if (ExtractorWithSerumRowsAbove::is_control_serum_cell(cell))
         return true;
 
     if (is_string(cell)) {
-        const auto text = fmt::format("{}", cell);
-        if (std::regex_search(text, re_NIID_serum_name_row_non_serum_label))
+        if (const auto text = std::get<std::string_view>(cell); anchor::NIID_serum_name_row_non_serum_label(text))
             return true;
     }
     return false;
@@ -1402,7 +1527,7 @@ acmacs::sheet::v1::ExtractorVIDRL::ExtractorVIDRL(std::shared_ptr<Sheet> a_sheet
 
 std::string acmacs::sheet::v1::ExtractorVIDRL::make_date(const std::string& src) const
 {
-    if (std::regex_search(src, re_VIDRL_antigen_date_column_title))
+    if (anchor::VIDRL_antigen_date_column_title(src))
         return {};              // column title in the antigen's row
     return ExtractorWithSerumRowsAbove::make_date(src);
 
@@ -1412,7 +1537,7 @@ std::string acmacs::sheet::v1::ExtractorVIDRL::make_date(const std::string& src)
 
 std::string acmacs::sheet::v1::ExtractorVIDRL::make_lab_id(const std::string& src) const
 {
-    if (std::regex_search(src, re_VIDRL_antigen_lab_id_column_title))
+    if (anchor::VIDRL_antigen_lab_id_column_title(src))
         return {};              // column title in the antigen's row
     return ExtractorWithSerumRowsAbove::make_lab_id(src);
 
@@ -1424,7 +1549,7 @@ acmacs::sheet::v1::serum_fields_t acmacs::sheet::v1::ExtractorVIDRL::serum(size_
 {
     auto serum = ExtractorWithSerumRowsAbove::serum(sr_no);
     if (serum_name_row_) {
-        serum.name = fmt::format("{}", sheet().cell(*serum_name_row_, serum_columns().at(sr_no)));
+        serum.name = sheet().text(*serum_name_row_, serum_columns().at(sr_no));
 
         // TAS503 -> A(H3N2)/TASMANIA/503/2020
         if (std::smatch match; std::regex_search(serum.name, match, re_VIDRL_serum_name)) {
@@ -1452,9 +1577,9 @@ void acmacs::sheet::v1::ExtractorVIDRL::adjust_titer_range(nrow_t row, column_ra
         // VIDRL mutant table may have serum_id looking like a titer. If
         // the row has serum ids to the left or to the right of titer
         // range, invalidate the range
-        // AD_DEBUG("vidrl adjust_titer_range {} {} {}", row, cr, sheet().grep(re_VIDRL_serum_id_with_days, {row, ncol_t{1}}, {row + nrow_t{1}, cr.first - ncol_t{1}}));
-        if (sheet().grep(re_VIDRL_serum_id_with_days, {row, ncol_t{1}}, {row + nrow_t{1}, cr.first - ncol_t{1}}).size() > 0 ||
-            sheet().grep(re_VIDRL_serum_id_with_days, {row, cr.second + ncol_t{1}}, {row + nrow_t{1}, sheet().number_of_columns()}).size() > 0) {
+        // AD_DEBUG("vidrl adjust_titer_range {} {} {}", row, cr, sheet().grep(anchor::VIDRL_serum_id_with_days, {row, ncol_t{1}}, {row + nrow_t{1}, cr.first - ncol_t{1}}));
+        if (sheet().grep(anchor::VIDRL_serum_id_with_days, {row, ncol_t{1}}, {row + nrow_t{1}, cr.first - ncol_t{1}}).size() > 0 ||
+            sheet().grep(anchor::VIDRL_serum_id_with_days, {row, cr.second + ncol_t{1}}, {row + nrow_t{1}, sheet().number_of_columns()}).size() > 0) {
             cr.first = ncol_t{max_row_col};
         }
     }
@@ -1463,9 +1588,9 @@ void acmacs::sheet::v1::ExtractorVIDRL::adjust_titer_range(nrow_t row, column_ra
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::ExtractorVIDRL::is_lab_id(const cell_t& cell) const
+bool acmacs::sheet::v1::ExtractorVIDRL::is_lab_id(const cell_view_t& cell) const
 {
-    return sheet().matches(re_VIDRL_antigen_lab_id, cell);
+    return sheet().matches(anchor::VIDRL_antigen_lab_id, cell);
 
 } // acmacs::sheet::v1::ExtractorVIDRL::is_lab_id
 
@@ -1473,14 +1598,20 @@ bool acmacs::sheet::v1::ExtractorVIDRL::is_lab_id(const cell_t& cell) const
 
 void acmacs::sheet::v1::ExtractorVIDRL::find_serum_rows(warn_if_not_found winf)
 {
-    find_serum_passage_row(re_serum_passage, winf);
-
     // VIDRL serum name can be confused with the passage by
-    // re_VIDRL_serum_name, that is why serum_passage_row_ detected
-    // first and then ignored while looking for serum name row
-
-    serum_name_row_ = find_serum_row(re_VIDRL_serum_name, "name", winf, serum_passage_row_);
-    find_serum_id_row(re_VIDRL_serum_id, winf);
+    // anchor::VIDRL_serum_name, that is why serum passage row is
+    // ignored while looking for serum name row
+
+    const auto rows = find_serum_rows_matching(
+        {
+            serum_row_pattern_t{.matcher = anchor::serum_passage, .row_name = "passage"},
+            serum_row_pattern_t{.matcher = anchor::VIDRL_serum_name, .row_name = "name", .ignore_row_of = 0},
+            serum_row_pattern_t{.matcher = anchor::VIDRL_serum_id, .row_name = "id"},
+        },
+        winf);
+    serum_passage_row_ = rows[0];
+    serum_name_row_ = rows[1];
+    serum_id_row_ = rows[2];
 
 } // acmacs::sheet::v1::ExtractorVIDRL::find_serum_rows
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <optional>
+#include <cstdint>
+#include <array>
+#include <bit>
 
 #include "acmacs-base/date.hh"
 #include "acmacs-base/flat-map.hh"
@@ -41,6 +44,48 @@ namespace acmacs::sheet::inline v1
 
     // ----------------------------------------------------------------------
 
+    // classification of the sheet cells, computed once by Extractor::classify_cells()
+    // in the same pass the longest titer run of each row is recorded
+    // per column counts of cell classes are collected for antigen rows when they are known, all classes at once
+    class cell_classes_t
+    {
+      public:
+        enum class_t : uint8_t { titer = 1 << 0, date = 1 << 1, virus_name = 1 << 2, passage = 1 << 3, lab_id = 1 << 4 };
+        static constexpr const size_t number_of_classes{5};
+
+        cell_classes_t() = default;
+        cell_classes_t(nrow_t number_of_rows, ncol_t number_of_columns)
+            : number_of_rows_{number_of_rows}, number_of_columns_{number_of_columns}, classes_(*number_of_rows * *number_of_columns, 0), titer_runs_(*number_of_rows)
+        {
+        }
+
+        bool is(class_t cls, nrow_t row, ncol_t col) const { return row < number_of_rows_ && col < number_of_columns_ && (classes_[index(row, col)] & cls) != 0; }
+        void set(nrow_t row, ncol_t col, uint8_t classes) { classes_[index(row, col)] = classes; }
+        void add(nrow_t row, ncol_t col, uint8_t classes) { classes_[index(row, col)] |= classes; }
+
+        // longest range of consecutive titer cells in the row, invalid range if row has no titers
+        const column_range& titer_run(nrow_t row) const { return titer_runs_[*row]; }
+        void titer_run(nrow_t row, const column_range& run) { titer_runs_[*row] = run; }
+
+        // count_rows() replaces counts with the ones for the passed rows, uncount_rows() removes rows counted before
+        void count_rows(const std::vector<nrow_t>& rows);
+        void uncount_rows(const std::vector<nrow_t>& rows) { tally(rows, -1); }
+        size_t count(class_t cls, ncol_t col) const { return col < ncol_t{counts_.size()} ? counts_[*col][class_index(cls)] : 0ul; }
+
+      private:
+        nrow_t number_of_rows_{0};
+        ncol_t number_of_columns_{0};
+        std::vector<uint8_t> classes_; // class_t bits per cell, a byte per cell: threads classifying different rows do not share memory
+        std::vector<column_range> titer_runs_; // per row
+        std::vector<std::array<size_t, number_of_classes>> counts_; // per column
+
+        size_t index(nrow_t row, ncol_t col) const { return *row * *number_of_columns_ + *col; }
+        static size_t class_index(class_t cls) { return static_cast<size_t>(std::countr_zero(static_cast<uint8_t>(cls))); }
+        void tally(const std::vector<nrow_t>& rows, int increment);
+    };
+
+    // ----------------------------------------------------------------------
+
     class Extractor
     {
       public:
@@ -75,7 +120,7 @@ namespace acmacs::sheet::inline v1
         void date(const date::year_month_day& a_date) { date_ = a_date; }
 
         enum class warn_if_not_found { no, yes };
-        void preprocess(warn_if_not_found winf);
+        void preprocess(warn_if_not_found winf, size_t number_of_threads = 0); // number_of_threads for classify_cells(), 0: hardware concurrency
 
         virtual void report_data_anchors() const;
         virtual void check_export_possibility() const; // throws Error if exporting is not possible
@@ -87,6 +132,7 @@ namespace acmacs::sheet::inline v1
         virtual const char* extractor_name() const { return "[Extractor]"; }
 
       protected:
+        void classify_cells(size_t number_of_threads);
         virtual void find_titers(warn_if_not_found winf);
         virtual void find_antigen_name_column(warn_if_not_found winf);
         virtual void remove_redundant_antigen_rows(warn_if_not_found winf);
@@ -94,7 +140,18 @@ namespace acmacs::sheet::inline v1
         virtual void find_antigen_passage_column(warn_if_not_found winf);
         virtual void find_antigen_lab_id_column(warn_if_not_found winf);
         virtual void find_serum_rows(warn_if_not_found) {}
-        virtual std::optional<nrow_t> find_serum_row(const std::regex& re, std::string_view row_name, warn_if_not_found winf, std::optional<nrow_t> ignore = std::nullopt) const;
+        virtual std::optional<nrow_t> find_serum_row(text_matcher_t matcher, std::string_view row_name, warn_if_not_found winf) const;
+
+        struct serum_row_pattern_t
+        {
+            text_matcher_t matcher;
+            std::string_view row_name;
+            size_t min_columns{0};                 // number of serum columns to match, 0: half of the serum columns
+            std::optional<size_t> ignore_row_of{}; // index of the pattern whose row is not considered for this pattern
+        };
+        // classifies rows above the antigens against all patterns in one sweep,
+        // returns for each pattern the first row matching in min_columns serum columns
+        std::vector<std::optional<nrow_t>> find_serum_rows_matching(const std::vector<serum_row_pattern_t>& patterns, warn_if_not_found winf) const;
         virtual void exclude_control_sera(warn_if_not_found winf) = 0;
         virtual void adjust_titer_range(nrow_t /*row*/, column_range& /*cr*/) {}
 
@@ -107,11 +164,12 @@ namespace acmacs::sheet::inline v1
 
         std::vector<ncol_t>& serum_columns() { return serum_columns_; }
 
-        virtual bool is_virus_name(nrow_t row, ncol_t col) const;
+        virtual bool is_virus_name(std::string_view text) const;
         // virtual bool is_passage(nrow_t row, ncol_t col) const;
-        virtual bool is_lab_id(const cell_t& /*cell*/) const { return false; }
+        // called concurrently for cells of different rows by classify_cells(), must not change state, log or use lazily initialized globals
+        virtual bool is_lab_id(const cell_view_t& /*cell*/) const { return false; }
         virtual bool valid_titer_row(nrow_t /*row*/, const column_range& /*cr*/) const { return true; }
-        virtual bool is_control_serum_cell(const cell_t& cell) const;
+        virtual bool is_control_serum_cell(const cell_view_t& cell) const;
 
         virtual std::string make_passage(const std::string& src) const;
         virtual std::string make_date(const std::string& src) const;
@@ -122,6 +180,7 @@ namespace acmacs::sheet::inline v1
         std::optional<ncol_t> antigen_name_column_, antigen_date_column_, antigen_passage_column_, antigen_lab_id_column_;
         std::vector<nrow_t> antigen_rows_;
         std::vector<ncol_t> serum_columns_;
+        cell_classes_t cell_classes_;
 
       private:
         std::shared_ptr<Sheet> sheet_;
@@ -134,7 +193,7 @@ namespace acmacs::sheet::inline v1
 
     };
 
-    std::unique_ptr<Extractor> extractor_factory(std::shared_ptr<Sheet> sheet, Extractor::warn_if_not_found winf);
+    std::unique_ptr<Extractor> extractor_factory(std::shared_ptr<Sheet> sheet, Extractor::warn_if_not_found winf, size_t number_of_threads = 0);
 
     // ----------------------------------------------------------------------
 
@@ -151,13 +210,13 @@ namespace acmacs::sheet::inline v1
         const char* extractor_name() const override { return "[CDC]"; }
 
       protected:
-        bool is_lab_id(const cell_t& cell) const override;
+        bool is_lab_id(const cell_view_t& cell) const override;
         void find_serum_rows(warn_if_not_found winf) override;
         virtual void find_serum_columns(warn_if_not_found winf);
-        virtual void find_serum_name_column(warn_if_not_found winf, const std::regex& re_serum_index);
-        void find_serum_column_label(const std::regex& re, std::optional<ncol_t>& col, std::string_view label_name);
-        void find_serum_column_label(const std::regex& re1, const std::regex& re2, std::optional<ncol_t>& col, std::string_view label_name);
-        void find_serum_index_row(warn_if_not_found winf, const std::regex& re_serum_index);
+        virtual void find_serum_name_column(warn_if_not_found winf, text_matcher_t serum_index);
+        void find_serum_column_label(const anchored_label_t& re, std::optional<ncol_t>& col, std::string_view label_name);
+        void find_serum_column_label(const anchored_label_t& re1, const anchored_label_t& re2, std::optional<ncol_t>& col, std::string_view label_name);
+        void find_serum_index_row(warn_if_not_found winf, text_matcher_t serum_index);
         void remove_redundant_antigen_rows(warn_if_not_found winf) override;
         void exclude_control_sera(warn_if_not_found winf) override;
         void adjust_titer_range(nrow_t row, column_range& cr) override;
@@ -166,7 +225,7 @@ namespace acmacs::sheet::inline v1
 
         std::string report_serum_anchors() const override;
 
-        virtual bool serum_index_matches(const cell_t& at_row, const cell_t& at_column) const;
+        virtual bool serum_index_matches(const cell_view_t& at_row, const cell_view_t& at_column) const;
 
         std::optional<nrow_t> serum_index_row_;
         std::vector<nrow_t> serum_rows_;
@@ -183,10 +242,10 @@ namespace acmacs::sheet::inline v1
         ExtractorAc21(std::shared_ptr<Sheet> a_sheet);
 
         const char* extractor_name() const override { return "[AC21]"; }
-        bool serum_index_matches(const cell_t& at_row, const cell_t& at_column) const override;
+        bool serum_index_matches(const cell_view_t& at_row, const cell_view_t& at_column) const override;
 
       protected:
-        // bool is_lab_id(const cell_t& cell) const override;
+        // bool is_lab_id(const cell_view_t& cell) const override;
         void find_antigen_lab_id_column(warn_if_not_found winf) override;
         void find_serum_rows(warn_if_not_found winf) override;
         void find_serum_columns(warn_if_not_found winf) override;
@@ -208,8 +267,6 @@ namespace acmacs::sheet::inline v1
         void force_serum_id_row(nrow_t row) override;
 
       protected:
-        virtual void find_serum_passage_row(const std::regex& re, warn_if_not_found winf) { serum_passage_row_ = find_serum_row(re, "passage", winf); }
-        virtual void find_serum_id_row(const std::regex& re, warn_if_not_found winf) { serum_id_row_ = find_serum_row(re, "id", winf); }
         void exclude_control_sera(warn_if_not_found winf) override;
 
         std::optional<nrow_t> serum_name_row() const { return serum_name_row_; }
@@ -237,7 +294,7 @@ namespace acmacs::sheet::inline v1
 
       protected:
         void find_serum_rows(warn_if_not_found winf) override;
-        void find_serum_name_rows(warn_if_not_found winf);
+        void find_serum_name_2_row(warn_if_not_found winf);
         void find_serum_less_than_substitutions(warn_if_not_found winf);
 
         std::string report_serum_anchors() const override;
@@ -281,7 +338,7 @@ namespace acmacs::sheet::inline v1
       protected:
         void find_antigen_lab_id_column(warn_if_not_found winf) override;
         void find_serum_rows(warn_if_not_found winf) override;
-        bool is_control_serum_cell(const cell_t& cell) const override;
+        bool is_control_serum_cell(const cell_view_t& cell) const override;
 
         std::string report_serum_anchors() const override;
     };
@@ -298,7 +355,7 @@ namespace acmacs::sheet::inline v1
         const char* extractor_name() const override { return "[VIDRL]"; }
 
       protected:
-        bool is_lab_id(const cell_t& cell) const override;
+        bool is_lab_id(const cell_view_t& cell) const override;
         void find_serum_rows(warn_if_not_found winf) override;
         std::string make_date(const std::string& src) const override;
         std::string make_lab_id(const std::string& src) const override;
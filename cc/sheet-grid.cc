@@ -0,0 +1,175 @@
+#include "acmacs-whocc/sheet-grid.hh"
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::cell_grid_t::cell_grid_t(const Sheet& source) : cell_grid_t(source.number_of_rows(), source.number_of_columns())
+{
+    for (nrow_t row{0}; row < number_of_rows_; ++row) {
+        for (ncol_t col{0}; col < number_of_columns_; ++col)
+            set(row, col, source.cell(row, col));
+    }
+
+} // acmacs::sheet::v1::cell_grid_t::cell_grid_t
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::cell_grid_t::cell_grid_t(nrow_t number_of_rows, ncol_t number_of_columns, std::vector<grid_cell_t>&& cells, std::string&& arena)
+    : cell_grid_t(number_of_rows, number_of_columns)
+{
+    if (cells.size() != cells_.size())
+        throw std::runtime_error{fmt::format("cell_grid_t: {} cells for {}x{} grid", cells.size(), number_of_rows, number_of_columns)};
+    cells_ = std::move(cells);
+    arena_ = std::move(arena);
+    for (nrow_t row{0}; row < number_of_rows_; ++row) {
+        for (ncol_t col{0}; col < number_of_columns_; ++col) {
+            const auto& cl = at(row, col);
+            switch (cl.tag_) {
+                case grid_cell_t::tag_t::empty:
+                    break;
+                case grid_cell_t::tag_t::inline_string:
+                    if (static_cast<size_t>(static_cast<uint8_t>(cl.payload_[0])) > grid_cell_t::inline_string_capacity)
+                        throw std::runtime_error{fmt::format("cell_grid_t: invalid inline string at {}{}", col, row)};
+                    if (cl.payload_[0] != 0)
+                        occupy(row, col);
+                    break;
+                case grid_cell_t::tag_t::string:
+                    if (const auto arena_string = cl.value<grid_cell_t::arena_string_t>(); static_cast<size_t>(arena_string.offset) + arena_string.size > arena_.size())
+                        throw std::runtime_error{fmt::format("cell_grid_t: invalid string at {}{}", col, row)};
+                    occupy(row, col);
+                    break;
+                case grid_cell_t::tag_t::error:
+                case grid_cell_t::tag_t::boolean:
+                case grid_cell_t::tag_t::real:
+                case grid_cell_t::tag_t::integer:
+                case grid_cell_t::tag_t::date:
+                    occupy(row, col);
+                    break;
+                default:
+                    throw std::runtime_error{fmt::format("cell_grid_t: invalid cell tag {} at {}{}", static_cast<unsigned>(cl.tag_), col, row)};
+            }
+        }
+    }
+
+} // acmacs::sheet::v1::cell_grid_t::cell_grid_t
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::cell_t acmacs::sheet::v1::cell_grid_t::cell(const grid_cell_t& src) const
+{
+    switch (src.tag_) {
+        case grid_cell_t::tag_t::empty:
+            return cell::empty{};
+        case grid_cell_t::tag_t::error:
+            return cell::error{};
+        case grid_cell_t::tag_t::boolean:
+            return src.value<bool>();
+        case grid_cell_t::tag_t::inline_string:
+        case grid_cell_t::tag_t::string:
+            return std::string{string(src)};
+        case grid_cell_t::tag_t::real:
+            return src.value<double>();
+        case grid_cell_t::tag_t::integer:
+            return src.value<long>();
+        case grid_cell_t::tag_t::date:
+            return date::year_month_day{date::sys_days{date::days{src.value<int32_t>()}}};
+    }
+    return cell::empty{};
+
+} // acmacs::sheet::v1::cell_grid_t::cell
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::cell_view_t acmacs::sheet::v1::cell_grid_t::cell_view(const grid_cell_t& src) const
+{
+    switch (src.tag_) {
+        case grid_cell_t::tag_t::empty:
+            return cell::empty{};
+        case grid_cell_t::tag_t::error:
+            return cell::error{};
+        case grid_cell_t::tag_t::boolean:
+            return src.value<bool>();
+        case grid_cell_t::tag_t::inline_string:
+        case grid_cell_t::tag_t::string:
+            return string(src);
+        case grid_cell_t::tag_t::real:
+            return src.value<double>();
+        case grid_cell_t::tag_t::integer:
+            return src.value<long>();
+        case grid_cell_t::tag_t::date:
+            return date::year_month_day{date::sys_days{date::days{src.value<int32_t>()}}};
+    }
+    return cell::empty{};
+
+} // acmacs::sheet::v1::cell_grid_t::cell_view
+
+// ----------------------------------------------------------------------
+
+void acmacs::sheet::v1::cell_grid_t::set(nrow_t row, ncol_t col, const cell_t& src)
+{
+    auto& target = cells_[index(row, col)];
+    if (!is_empty(src) && !(is_string(src) && std::get<std::string>(src).empty()))
+        occupy(row, col);
+    std::visit(
+        [this, &target]<typename Content>(const Content& arg) {
+            if constexpr (std::is_same_v<Content, cell::empty>) {
+                target.tag_ = grid_cell_t::tag_t::empty;
+            }
+            else if constexpr (std::is_same_v<Content, cell::error>) {
+                target.tag_ = grid_cell_t::tag_t::error;
+            }
+            else if constexpr (std::is_same_v<Content, bool>) {
+                target.set(grid_cell_t::tag_t::boolean, arg);
+            }
+            else if constexpr (std::is_same_v<Content, std::string>) {
+                set_string(target, arg);
+            }
+            else if constexpr (std::is_same_v<Content, double>) {
+                target.set(grid_cell_t::tag_t::real, arg);
+            }
+            else if constexpr (std::is_same_v<Content, long>) {
+                target.set(grid_cell_t::tag_t::integer, arg);
+            }
+            else if constexpr (std::is_same_v<Content, date::year_month_day>) {
+                target.set(grid_cell_t::tag_t::date, static_cast<int32_t>(date::sys_days{arg}.time_since_epoch().count()));
+            }
+        },
+        src);
+
+} // acmacs::sheet::v1::cell_grid_t::set
+
+// ----------------------------------------------------------------------
+
+void acmacs::sheet::v1::cell_grid_t::set_string(nrow_t row, ncol_t col, std::string_view src)
+{
+    set_string(cells_[index(row, col)], src);
+    if (!src.empty())
+        occupy(row, col);
+
+} // acmacs::sheet::v1::cell_grid_t::set_string
+
+// ----------------------------------------------------------------------
+
+void acmacs::sheet::v1::cell_grid_t::set_string(grid_cell_t& target, std::string_view src)
+{
+    if (src.size() <= grid_cell_t::inline_string_capacity) {
+        target.set_inline_string(src);
+    }
+    else {
+        target.set(grid_cell_t::tag_t::string, grid_cell_t::arena_string_t{.offset = static_cast<uint32_t>(arena_.size()), .size = static_cast<uint32_t>(src.size())});
+        arena_.append(src);
+    }
+
+} // acmacs::sheet::v1::cell_grid_t::set_string
+
+// ----------------------------------------------------------------------
+
+std::shared_ptr<acmacs::sheet::v1::GridSheet> acmacs::sheet::v1::GridSheet::materialize(const Sheet& source)
+{
+    return std::make_shared<GridSheet>(source.name(), cell_grid_t{source});
+
+} // acmacs::sheet::v1::GridSheet::materialize
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
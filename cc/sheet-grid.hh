@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "acmacs-whocc/sheet.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::sheet::inline v1
+{
+    enum class materialize { no, yes }; // yes: backend reads sheet once into GridSheet
+
+    // compact typed cell of a materialized sheet: 1-byte tag and 15 bytes of payload
+    // strings up to inline_string_capacity (titers, passages, short ids) are kept in the cell, longer ones in the arena of cell_grid_t
+    class grid_cell_t
+    {
+      public:
+        enum class tag_t : uint8_t { empty, error, boolean, inline_string, string, real, integer, date };
+        static constexpr size_t inline_string_capacity{14};
+
+        constexpr grid_cell_t() = default;
+
+        constexpr tag_t tag() const { return tag_; }
+        constexpr bool empty() const { return tag_ == tag_t::empty; }
+
+      private:
+        struct arena_string_t
+        {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        static constexpr size_t value_offset{7}; // non-string values are at offset 8 of the cell
+
+        tag_t tag_{tag_t::empty};
+        char payload_[15]{}; // inline string: size followed by chars, other types: value at payload_ + value_offset
+
+        template <typename T> T value() const
+        {
+            static_assert(sizeof(T) <= sizeof(payload_) - value_offset);
+            T result;
+            std::memcpy(&result, payload_ + value_offset, sizeof(T));
+            return result;
+        }
+
+        template <typename T> void set(tag_t tag, T val)
+        {
+            static_assert(sizeof(T) <= sizeof(payload_) - value_offset);
+            tag_ = tag;
+            std::memcpy(payload_ + value_offset, &val, sizeof(T));
+        }
+
+        std::string_view inline_string() const { return std::string_view{payload_ + 1, static_cast<size_t>(payload_[0])}; }
+
+        void set_inline_string(std::string_view src)
+        {
+            tag_ = tag_t::inline_string;
+            payload_[0] = static_cast<char>(src.size());
+            std::memcpy(payload_ + 1, src.data(), src.size());
+        }
+
+        friend class cell_grid_t;
+    };
+
+    static_assert(sizeof(grid_cell_t) == 16);
+    static_assert(std::is_trivially_copyable_v<grid_cell_t>);
+
+    // ----------------------------------------------------------------------
+
+    // row-major grid of compact cells with per-sheet arena for long strings, 300x60 sheet is ~280Kb
+    class cell_grid_t
+    {
+      public:
+        cell_grid_t() = default;
+        cell_grid_t(nrow_t number_of_rows, ncol_t number_of_columns)
+            : number_of_rows_{number_of_rows}, number_of_columns_{number_of_columns}, cells_(*number_of_rows * *number_of_columns), occupancy_{std::vector<bool>(*number_of_rows, false), std::vector<bool>(*number_of_columns, false)}
+        {
+        }
+        explicit cell_grid_t(const Sheet& source); // reads all cells of source
+        cell_grid_t(nrow_t number_of_rows, ncol_t number_of_columns, std::vector<grid_cell_t>&& cells, std::string&& arena); // raw content (e.g. of a snapshot) is validated, occupancy is recomputed
+
+        nrow_t number_of_rows() const { return number_of_rows_; }
+        ncol_t number_of_columns() const { return number_of_columns_; }
+
+        const grid_cell_t& at(nrow_t row, ncol_t col) const { return cells_[index(row, col)]; }
+        cell_t cell(nrow_t row, ncol_t col) const { return cell(at(row, col)); }
+        cell_t cell(const grid_cell_t& src) const;
+        cell_view_t cell_view(nrow_t row, ncol_t col) const { return cell_view(at(row, col)); }
+        cell_view_t cell_view(const grid_cell_t& src) const;
+        std::string_view string(const grid_cell_t& src) const
+        {
+            if (src.tag_ == grid_cell_t::tag_t::inline_string)
+                return src.inline_string();
+            const auto arena_string = src.value<grid_cell_t::arena_string_t>();
+            return std::string_view{arena_.data() + arena_string.offset, arena_string.size};
+        }
+
+        row_span_t row(nrow_t row) const;
+        column_span_t column(ncol_t col) const;
+        const occupancy_t& occupancy() const { return occupancy_; } // updated by set() and set_string()
+
+        // raw content, grid_cell_t is trivially copyable
+        const std::vector<grid_cell_t>& cells() const { return cells_; }
+        std::string_view arena() const { return arena_; }
+
+        void set(nrow_t row, ncol_t col, const cell_t& src);
+        void set_string(nrow_t row, ncol_t col, std::string_view src);
+
+      private:
+        nrow_t number_of_rows_{0};
+        ncol_t number_of_columns_{0};
+        std::vector<grid_cell_t> cells_;
+        std::string arena_;
+        occupancy_t occupancy_;
+
+        size_t index(nrow_t row, ncol_t col) const { return *row * *number_of_columns_ + *col; }
+        void occupy(nrow_t row, ncol_t col)
+        {
+            occupancy_.rows[*row] = true;
+            occupancy_.columns[*col] = true;
+        }
+        void set_string(grid_cell_t& target, std::string_view src);
+    };
+
+    // ----------------------------------------------------------------------
+
+    // strided view of grid cells, either a row (indexed by column) or a column (indexed by row)
+    template <NRowCol index_t> class cell_span_t
+    {
+      public:
+        class iterator
+        {
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = cell_view_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = cell_view_t;
+
+            iterator() = default;
+
+            cell_view_t operator*() const { return span_->operator[](index_t{pos_}); }
+            iterator& operator++() { ++pos_; return *this; }
+            iterator operator++(int) { auto result = *this; ++pos_; return result; }
+            bool operator==(const iterator& rhs) const { return pos_ == rhs.pos_; }
+
+          private:
+            const cell_span_t* span_{nullptr};
+            size_t pos_{0};
+
+            iterator(const cell_span_t* span, size_t pos) : span_{span}, pos_{pos} {}
+
+            friend class cell_span_t;
+        };
+
+        cell_span_t(const cell_grid_t& grid, const grid_cell_t* first, size_t size, size_t stride) : grid_{grid}, first_{first}, size_{size}, stride_{stride} {}
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const grid_cell_t& at(index_t index) const { return first_[*index * stride_]; }
+        cell_view_t operator[](index_t index) const { return grid_.cell_view(at(index)); }
+
+        iterator begin() const { return iterator{this, 0}; }
+        iterator end() const { return iterator{this, size_}; }
+
+      private:
+        const cell_grid_t& grid_;
+        const grid_cell_t* first_;
+        size_t size_;
+        size_t stride_;
+    };
+
+    inline row_span_t cell_grid_t::row(nrow_t row) const { return row_span_t{*this, cells_.data() + index(row, ncol_t{0}), *number_of_columns_, 1}; }
+    inline column_span_t cell_grid_t::column(ncol_t col) const { return column_span_t{*this, cells_.data() + *col, *number_of_rows_, *number_of_columns_}; }
+
+    // ----------------------------------------------------------------------
+
+    // sheet materialized into cell_grid_t, repeated scans are plain array reads
+    class GridSheet : public Sheet
+    {
+      public:
+        GridSheet(std::string_view a_name, cell_grid_t&& a_grid) : name_{a_name}, grid_{std::move(a_grid)} {}
+
+        std::string name() const override { return name_; }
+        nrow_t number_of_rows() const override { return grid_.number_of_rows(); }
+        ncol_t number_of_columns() const override { return grid_.number_of_columns(); }
+        cell_t cell(nrow_t row, ncol_t col) const override { return grid_.cell(row, col); }                // row and col are zero based
+        cell_view_t cell_view(nrow_t row, ncol_t col) const override { return grid_.cell_view(row, col); } // row and col are zero based
+
+        const cell_grid_t& grid() const override { return grid_; }
+
+        static std::shared_ptr<GridSheet> materialize(const Sheet& source);
+
+      private:
+        std::string name_;
+        cell_grid_t grid_;
+    };
+
+} // namespace acmacs::sheet::inline v1
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
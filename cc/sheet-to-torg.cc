@@ -8,9 +8,9 @@
 
 // ----------------------------------------------------------------------
 
-void acmacs::sheet::v1::SheetToTorg::preprocess(Extractor::warn_if_not_found winf)
+void acmacs::sheet::v1::SheetToTorg::preprocess(Extractor::warn_if_not_found winf, size_t number_of_threads)
 {
-    extractor_ = extractor_factory(sheet(), winf);
+    extractor_ = extractor_factory(sheet(), winf, number_of_threads);
 
 } // acmacs::sheet::v1::SheetToTorg::preprocess
 
@@ -1,15 +1,122 @@
 #include "acmacs-base/range-v3.hh"
-#include "acmacs-whocc/sheet.hh"
+#include "acmacs-base/string-compare.hh"
+#include "acmacs-whocc/sheet-grid.hh"
+#include "acmacs-whocc/titer-lexer.hh"
 #include "acmacs-whocc/log.hh"
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, const cell_t& cell)
+acmacs::sheet::v1::Sheet::~Sheet() = default;
+
+// ----------------------------------------------------------------------
+
+bool acmacs::sheet::v1::is_ignored_sheet_name(std::string_view name)
+{
+    return acmacs::string::startswith_ignore_case(name, "AC-IGNORE");
+
+} // acmacs::sheet::v1::is_ignored_sheet_name
+
+// ----------------------------------------------------------------------
+
+std::string_view acmacs::sheet::v1::sheet_info_t::ignore_reason() const
+{
+    using namespace std::string_view_literals;
+
+    if (is_ignored_sheet_name(name))
+        return "ignored on request in sheet name"sv;
+    // some writers always record A1 as dimension, it is not trusted
+    if (dimension.has_value() && (dimension->row != nrow_t{1} || dimension->col != ncol_t{1}) && (dimension->row < minimal_number_of_rows || dimension->col < minimal_number_of_columns))
+        return "is too small, ignored"sv;
+    return {};
+
+} // acmacs::sheet::v1::sheet_info_t::ignore_reason
+
+// ----------------------------------------------------------------------
+
+const acmacs::sheet::v1::cell_grid_t& acmacs::sheet::v1::Sheet::grid() const
+{
+    std::call_once(grid_materialized_, [this]() { grid_ = std::make_unique<cell_grid_t>(*this); });
+    return *grid_;
+
+} // acmacs::sheet::v1::Sheet::grid
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::row_span_t acmacs::sheet::v1::Sheet::row(nrow_t row) const
+{
+    return grid().row(row);
+
+} // acmacs::sheet::v1::Sheet::row
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::column_span_t acmacs::sheet::v1::Sheet::column(ncol_t col) const
+{
+    return grid().column(col);
+
+} // acmacs::sheet::v1::Sheet::column
+
+// ----------------------------------------------------------------------
+
+const acmacs::sheet::v1::occupancy_t& acmacs::sheet::v1::Sheet::occupancy() const
+{
+    return grid().occupancy();
+
+} // acmacs::sheet::v1::Sheet::occupancy
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::v1::cell_view_t acmacs::sheet::v1::Sheet::cell_view(nrow_t row, ncol_t col) const
+{
+    return std::visit(
+        [this, row, col]<typename Content>(Content&& arg) -> cell_view_t {
+            if constexpr (std::is_same_v<std::decay_t<Content>, std::string>) {
+                // backend does not keep cell content, string is stored in the sheet for the lifetime of the sheet
+                std::unique_lock lock{cell_view_strings_access_};
+                return std::string_view{cell_view_strings_.try_emplace(*row * *number_of_columns() + *col, std::move(arg)).first->second};
+            }
+            else
+                return arg;
+        },
+        cell(row, col));
+
+} // acmacs::sheet::v1::Sheet::cell_view
+
+// ----------------------------------------------------------------------
+
+std::string_view acmacs::sheet::v1::Sheet::text(nrow_t row, ncol_t col) const
+{
+    const auto cell = cell_view(row, col);
+    if (const auto* str = std::get_if<std::string_view>(&cell); str)
+        return *str;
+    if (is_empty(cell))
+        return {};
+
+    std::unique_lock lock{cell_view_strings_access_};
+    const auto key = *row * *number_of_columns() + *col;
+    if (const auto found = cell_view_strings_.find(key); found != cell_view_strings_.end())
+        return found->second;
+    return cell_view_strings_.emplace(key, fmt::format("{}", cell)).first->second;
+
+} // acmacs::sheet::v1::Sheet::text
+
+// ----------------------------------------------------------------------
+
+bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, nrow_t row, ncol_t col) const
+{
+    const auto txt = text(row, col); // CDC id is a number in CDC tables, still we want to match
+    return std::regex_search(txt.data(), txt.data() + txt.size(), re);
+
+} // acmacs::sheet::v1::Sheet::matches
+
+// ----------------------------------------------------------------------
+
+bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, const cell_view_t& cell)
 {
     return std::visit(
         [&re, &cell]<typename Content>(const Content& arg) {
-            if constexpr (std::is_same_v<Content, std::string>)
-                return std::regex_search(arg, re);
+            if constexpr (std::is_same_v<Content, std::string_view>)
+                return std::regex_search(arg.data(), arg.data() + arg.size(), re);
             else
                 return std::regex_search(fmt::format("{}", cell), re); // CDC id is a number in CDC tables, still we want to match
         },
@@ -19,12 +126,12 @@ bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, const cell_t& cell)
 
 // ----------------------------------------------------------------------
 
-bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, std::smatch& match, const cell_t& cell)
+bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, std::cmatch& match, const cell_view_t& cell)
 {
     return std::visit(
         [&re, &match]<typename Content>(const Content& arg) {
-            if constexpr (std::is_same_v<Content, std::string>)
-                return std::regex_search(arg, match, re);
+            if constexpr (std::is_same_v<Content, std::string_view>)
+                return std::regex_search(arg.data(), arg.data() + arg.size(), match, re);
             else
                 return false;
         },
@@ -34,11 +141,26 @@ bool acmacs::sheet::v1::Sheet::matches(const std::regex& re, std::smatch& match,
 
 // ----------------------------------------------------------------------
 
-size_t acmacs::sheet::v1::Sheet::size(const cell_t& cell) const
+bool acmacs::sheet::v1::Sheet::matches(text_matcher_t matcher, const cell_view_t& cell)
+{
+    return std::visit(
+        [matcher, &cell]<typename Content>(const Content& arg) {
+            if constexpr (std::is_same_v<Content, std::string_view>)
+                return matcher(arg);
+            else
+                return matcher(fmt::format("{}", cell)); // CDC id is a number in CDC tables, still we want to match
+        },
+        cell);
+
+} // acmacs::sheet::v1::Sheet::matches
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::sheet::v1::Sheet::size(const cell_view_t& cell)
 {
     return std::visit(
         []<typename Content>(const Content& arg) {
-            if constexpr (std::is_same_v<Content, std::string>)
+            if constexpr (std::is_same_v<Content, std::string_view>)
                 return arg.size();
             else
                 return 0ul;
@@ -49,25 +171,17 @@ size_t acmacs::sheet::v1::Sheet::size(const cell_t& cell) const
 
 // ----------------------------------------------------------------------
 
-#include "acmacs-base/global-constructors-push.hh"
-
-// \xEF\xBC\x9C -> "<" unicode Fullwidth Less-Than Sign &#xFF1C; (NIID)
-// ">" and "," - perhaps typos in Crick tables
-static const std::regex re_titer{R"(^\s*(<|>|,|(?:<|>|\xEF\xBC\x9C)?\s*[1-9][0-9]{0,5}|N[DAT]|QNS|\*)\s*$)", acmacs::regex::icase};
-
-#include "acmacs-base/diagnostics-pop.hh"
-
-bool acmacs::sheet::v1::Sheet::maybe_titer(const cell_t& cell) const
+bool acmacs::sheet::v1::Sheet::maybe_titer(const cell_view_t& cell)
 {
     return std::visit(
         []<typename Content>(const Content& arg) {
-            if constexpr (std::is_same_v<Content, std::string>) {
+            if constexpr (std::is_same_v<Content, std::string_view>) {
                 // if (!arg.empty() && static_cast<unsigned char>(arg[0]) > 0x7F) {
                 //     AD_DEBUG("titer? \"{}\"", arg);
                 //     for (auto cc : arg)
                 //         AD_DEBUG("titer? 0x{:X}", static_cast<unsigned char>(cc));
                 // }
-                return std::regex_search(arg, re_titer);
+                return is_titer(arg);
             }
             else if constexpr (std::is_same_v<Content, double> || std::is_same_v<Content, long>)
                 return arg > 0;
@@ -82,48 +196,63 @@ bool acmacs::sheet::v1::Sheet::maybe_titer(const cell_t& cell) const
 
 acmacs::sheet::v1::column_range acmacs::sheet::v1::Sheet::titer_range(nrow_t row) const
 {
-    range<ncol_t> longest;
-    range<ncol_t> current;
-    const auto update = [&longest, &current] {
-        if (current.valid()) {
-            if (!longest.valid() || longest.length() < current.length()) {
-                longest = current;
-                // AD_DEBUG("longest {}: {}", row, longest);
-            }
-            current = range<ncol_t>{};
-        }
-    };
-
-    for (auto col = ncol_t{0}; col < number_of_columns(); ++col) {
-        // AD_DEBUG("maybe_titer {}:{} \"{}\"", row, col, cell(row, col));
-        if (maybe_titer(row, col)) {
-            if (!current.valid())
-                current.first = col;
-            current.second = col;
-            // AD_DEBUG("titer {}{}: {} --> {}", row, col, cell(row, col), current);
-        }
-        else
-            update();
-    }
-    update();
-    return longest;
+    if (!occupancy().row(row))
+        return {};
+    const auto cells = this->row(row);
+    return longest_column_range(number_of_columns(), [&cells](ncol_t col) { return maybe_titer(cells[col]); });
 
 } // acmacs::sheet::v1::Sheet::titer_range
 
 // ----------------------------------------------------------------------
 
+static inline acmacs::sheet::cell_match_t make_cell_match(acmacs::sheet::nrow_t row, acmacs::sheet::ncol_t col, const std::cmatch& match)
+{
+    acmacs::sheet::cell_match_t cm{.row = row, .col = col, .matches = std::vector<std::string>(match.size())};
+    std::transform(std::cbegin(match), std::cend(match), std::begin(cm.matches), [](const auto& submatch) { return submatch.str(); });
+    return cm;
+}
+
 std::vector<acmacs::sheet::cell_match_t> acmacs::sheet::v1::Sheet::grep(const std::regex& rex, const cell_addr_t& min, const cell_addr_t& max) const
 {
     std::vector<cell_match_t> result;
-    for (auto row = min.row; row < max.row; ++row) {
-        for (auto col = min.col; col < max.col; ++col) {
-            const auto cl = cell(row, col);
+    const cell_addr_t last{std::min(max.row, number_of_rows()), std::min(max.col, number_of_columns())}; // callers may pass max beyond the sheet
+    const auto& occupied = occupancy();
+    for (auto row = min.row; row < last.row; ++row) {
+        if (!occupied.row(row))
+            continue;
+        const auto cells = this->row(row);
+        for (auto col = min.col; col < last.col; ++col) {
+            if (!occupied.column(col))
+                continue;
+            const auto cl = cells[col];
             // AD_DEBUG("Sheet::grep {} {} \"{}\"", row, col, cl);
-            std::smatch match;
+            std::cmatch match;
             if (matches(rex, match, cl)) {
-                cell_match_t cm{.row = row, .col = col, .matches = std::vector<std::string>(match.size())};
-                std::transform(std::cbegin(match), std::cend(match), std::begin(cm.matches), [](const auto& submatch) { return submatch.str(); });
-                result.push_back(std::move(cm));
+                result.push_back(make_cell_match(row, col, match));
+            }
+        }
+    }
+    return result;
+
+} // acmacs::sheet::v1::Sheet::grep
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::sheet::cell_match_t> acmacs::sheet::v1::Sheet::grep(text_matcher_t matcher, const cell_addr_t& min, const cell_addr_t& max) const
+{
+    std::vector<cell_match_t> result;
+    const cell_addr_t last{std::min(max.row, number_of_rows()), std::min(max.col, number_of_columns())}; // callers may pass max beyond the sheet
+    const auto& occupied = occupancy();
+    for (auto row = min.row; row < last.row; ++row) {
+        if (!occupied.row(row))
+            continue;
+        const auto cells = this->row(row);
+        for (auto col = min.col; col < last.col; ++col) {
+            if (!occupied.column(col))
+                continue;
+            if (const auto cl = cells[col]; is_string(cl)) {
+                if (const auto text = std::get<std::string_view>(cl); matcher(text))
+                    result.push_back(cell_match_t{.row = row, .col = col, .matches = {std::string{text}}});
             }
         }
     }
@@ -133,22 +262,247 @@ std::vector<acmacs::sheet::cell_match_t> acmacs::sheet::v1::Sheet::grep(const st
 
 // ----------------------------------------------------------------------
 
+std::vector<std::vector<acmacs::sheet::cell_match_t>> acmacs::sheet::v1::Sheet::grep_many(const std::vector<const std::regex*>& rexes, const cell_addr_t& min, const cell_addr_t& max) const
+{
+    std::vector<std::vector<cell_match_t>> result(rexes.size());
+    const cell_addr_t last{std::min(max.row, number_of_rows()), std::min(max.col, number_of_columns())}; // callers may pass max beyond the sheet
+    const auto& occupied = occupancy();
+    std::cmatch match;
+    for (auto row = min.row; row < last.row; ++row) {
+        if (!occupied.row(row))
+            continue;
+        const auto cells = this->row(row);
+        for (auto col = min.col; col < last.col; ++col) {
+            if (!occupied.column(col))
+                continue;
+            if (const auto cl = cells[col]; is_string(cl)) {
+                for (size_t rex_no = 0; rex_no < rexes.size(); ++rex_no) {
+                    if (matches(*rexes[rex_no], match, cl))
+                        result[rex_no].push_back(make_cell_match(row, col, match));
+                }
+            }
+        }
+    }
+    return result;
+
+} // acmacs::sheet::v1::Sheet::grep_many
+
+// ----------------------------------------------------------------------
+
 std::vector<acmacs::sheet::cell_match_t> acmacs::sheet::v1::Sheet::grepv(const std::regex& rex1, const std::regex& rex2, const cell_addr_t& min, const cell_addr_t& max) const
 {
     std::vector<cell_match_t> result;
-    for (auto row = min.row; row < max.row; ++row) {
-        for (auto col = min.col; col < max.col; ++col) {
-            const auto cl1 = cell(row, col);
-            const auto cl2 = cell(row + nrow_t{1}, col);
+    if (number_of_rows() == nrow_t{0})
+        return result;
+    const cell_addr_t last{std::min(max.row, number_of_rows() - nrow_t{1}), std::min(max.col, number_of_columns())}; // second cell must be inside the sheet
+    const auto& occupied = occupancy();
+    for (auto row = min.row; row < last.row; ++row) {
+        if (!occupied.row(row) || !occupied.row(row + nrow_t{1}))
+            continue;
+        const auto cells1 = this->row(row);
+        const auto cells2 = this->row(row + nrow_t{1});
+        for (auto col = min.col; col < last.col; ++col) {
+            const auto cl1 = cells1[col];
+            const auto cl2 = cells2[col];
             // AD_DEBUG("Sheet::grep {} {} \"{}\"", row, col, cl);
-            std::smatch match;
+            std::cmatch match;
             if (matches(rex1, cl1) && matches(rex2, match, cl2)) {
-                cell_match_t cm{.row = row, .col = col, .matches = std::vector<std::string>(match.size())};
-                std::transform(std::cbegin(match), std::cend(match), std::begin(cm.matches), [](const auto& submatch) { return submatch.str(); });
-                result.push_back(std::move(cm));
+                result.push_back(make_cell_match(row, col, match));
+            }
+        }
+    }
+    return result;
+
+} // acmacs::sheet::v1::Sheet::grepv
+
+// ----------------------------------------------------------------------
+
+static inline bool is_label_space(char cc) { return cc == ' ' || cc == '\t' || cc == '\n' || cc == '\v' || cc == '\f' || cc == '\r'; }
+static inline char label_upper(char cc) { return (cc >= 'a' && cc <= 'z') ? static_cast<char>(cc - 'a' + 'A') : cc; }
+
+std::string acmacs::sheet::v1::normalize_label(std::string_view text)
+{
+    std::string result;
+    result.reserve(text.size());
+    bool space{false};
+    for (const char cc : text) {
+        if (is_label_space(cc)) {
+            space = !result.empty();
+        }
+        else {
+            if (space)
+                result.append(1, ' ');
+            space = false;
+            result.append(1, label_upper(cc));
+        }
+    }
+    return result;
+
+} // acmacs::sheet::v1::normalize_label
+
+// ----------------------------------------------------------------------
+
+// all normalized texts matched by pattern, empty if pattern is not a plain anchored text
+static std::vector<std::string> anchored_label_keys(std::string_view pattern)
+{
+    constexpr size_t max_keys{256};
+    constexpr std::string_view special{".[]{}()|*+?^$"};
+
+    if (pattern.size() < 3 || pattern.front() != '^' || pattern.back() != '$' || pattern[pattern.size() - 2] == '\\')
+        return {};
+    const auto body = pattern.substr(1, pattern.size() - 2);
+
+    std::vector<std::string> expanded{std::string{}};
+    const auto append = [&expanded](std::initializer_list<std::string_view> alternatives) {
+        std::vector<std::string> result;
+        for (const auto& prefix : expanded) {
+            for (const auto& alternative : alternatives)
+                result.push_back(prefix + std::string{alternative});
+        }
+        expanded = std::move(result);
+        return expanded.size() <= max_keys;
+    };
+
+    for (size_t pos = 0; pos < body.size();) {
+        char literal{0};
+        if (body[pos] == '\\') {
+            if (pos + 1 == body.size())
+                return {};
+            const char escaped = body[pos + 1];
+            pos += 2;
+            if (escaped == 's') {
+                bool ok{true};
+                if (pos < body.size() && body[pos] == '*') {
+                    ok = append({"", " "});
+                    ++pos;
+                }
+                else {
+                    if (pos < body.size() && body[pos] == '+')
+                        ++pos;
+                    ok = append({" "});
+                }
+                if (!ok)
+                    return {};
+                continue;
+            }
+            else if ((escaped >= '0' && escaped <= '9') || (escaped >= 'a' && escaped <= 'z') || (escaped >= 'A' && escaped <= 'Z'))
+                return {}; // \d \w \b etc.
+            literal = escaped;
+        }
+        else if (special.find(body[pos]) != std::string_view::npos)
+            return {};
+        else
+            literal = body[pos++];
+
+        const char text[1]{label_upper(literal)};
+        bool ok{true};
+        if (pos < body.size() && body[pos] == '?') {
+            ok = append({std::string_view{}, std::string_view{text, 1}});
+            ++pos;
+        }
+        else if (pos < body.size() && special.find(body[pos]) != std::string_view::npos)
+            return {};
+        else
+            ok = append({std::string_view{text, 1}});
+        if (!ok)
+            return {};
+    }
+
+    std::vector<std::string> keys;
+    for (const auto& text : expanded) {
+        auto key = acmacs::sheet::normalize_label(text);
+        // non-string cells (e.g. numbers) are not indexed, label must contain a letter
+        if (std::none_of(std::begin(key), std::end(key), [](char cc) { return cc >= 'A' && cc <= 'Z'; }))
+            return {};
+        keys.push_back(std::move(key));
+    }
+    std::sort(std::begin(keys), std::end(keys));
+    keys.erase(std::unique(std::begin(keys), std::end(keys)), std::end(keys));
+    return keys;
+}
+
+acmacs::sheet::v1::anchored_label_t::anchored_label_t(const char* pattern, std::regex::flag_type flags)
+    : regex_{pattern, flags}, keys_{(flags & std::regex::icase) ? anchored_label_keys(pattern) : std::vector<std::string>{}}
+{
+} // acmacs::sheet::v1::anchored_label_t::anchored_label_t
+
+// ----------------------------------------------------------------------
+
+const acmacs::sheet::v1::text_index_t& acmacs::sheet::v1::Sheet::text_index() const
+{
+    std::call_once(text_index_built_, [this]() {
+        const auto& occupied = occupancy();
+        for (auto row = nrow_t{0}; row < number_of_rows(); ++row) {
+            if (!occupied.row(row))
+                continue;
+            const auto cells = this->row(row);
+            for (auto col = ncol_t{0}; col < number_of_columns(); ++col) {
+                if (const auto cl = cells[col]; is_string(cl)) {
+                    if (auto key = normalize_label(std::get<std::string_view>(cl)); !key.empty())
+                        text_index_[std::move(key)].push_back(cell_addr_t{row, col});
+                }
+            }
+        }
+    });
+    return text_index_;
+
+} // acmacs::sheet::v1::Sheet::text_index
+
+// ----------------------------------------------------------------------
+
+static inline void sort_cell_matches(std::vector<acmacs::sheet::cell_match_t>& matches)
+{
+    // the same order as scanning cells
+    std::sort(std::begin(matches), std::end(matches), [](const auto& e1, const auto& e2) { return e1.row == e2.row ? e1.col < e2.col : e1.row < e2.row; });
+}
+
+std::vector<acmacs::sheet::cell_match_t> acmacs::sheet::v1::Sheet::grep(const anchored_label_t& label, const cell_addr_t& min, const cell_addr_t& max) const
+{
+    if (!label.indexable())
+        return grep(label.regex(), min, max);
+
+    std::vector<cell_match_t> result;
+    const auto& index = text_index();
+    std::cmatch match;
+    for (const auto& key : label.keys()) {
+        if (const auto found = index.find(key); found != index.end()) {
+            for (const auto& addr : found->second) {
+                // regex is re-applied to obtain match groups
+                if (addr.row >= min.row && addr.row < max.row && addr.col >= min.col && addr.col < max.col && matches(label.regex(), match, cell_view(addr.row, addr.col)))
+                    result.push_back(make_cell_match(addr.row, addr.col, match));
+            }
+        }
+    }
+    if (label.keys().size() > 1)
+        sort_cell_matches(result);
+    return result;
+
+} // acmacs::sheet::v1::Sheet::grep
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::sheet::cell_match_t> acmacs::sheet::v1::Sheet::grepv(const anchored_label_t& label1, const anchored_label_t& label2, const cell_addr_t& min, const cell_addr_t& max) const
+{
+    if (!label2.indexable())
+        return grepv(label1.regex(), label2.regex(), min, max);
+
+    std::vector<cell_match_t> result;
+    const auto& index = text_index();
+    std::cmatch match;
+    for (const auto& key : label2.keys()) {
+        if (const auto found = index.find(key); found != index.end()) {
+            for (const auto& addr : found->second) {
+                if (addr.row == nrow_t{0})
+                    continue;
+                const auto row = addr.row - nrow_t{1};
+                if (row >= min.row && row < max.row && addr.col >= min.col && addr.col < max.col && matches(label1, cell_view(row, addr.col)) &&
+                    matches(label2.regex(), match, cell_view(addr.row, addr.col)))
+                    result.push_back(make_cell_match(row, addr.col, match));
             }
         }
     }
+    if (label2.keys().size() > 1)
+        sort_cell_matches(result);
     return result;
 
 } // acmacs::sheet::v1::Sheet::grepv
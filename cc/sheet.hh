@@ -2,6 +2,10 @@
 
 #include <variant>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
 #include "acmacs-base/fmt.hh"
 #include "acmacs-base/date.hh"
@@ -25,7 +29,12 @@ namespace acmacs::sheet::inline v1
 
     using cell_t = std::variant<cell::empty, cell::error, bool, std::string, double, long, date::year_month_day>;
 
-    inline bool is_empty(const cell_t& cell)
+    // non-owning cell content, string refers to the storage owned by the sheet
+    using cell_view_t = std::variant<cell::empty, cell::error, bool, std::string_view, double, long, date::year_month_day>;
+
+    template <typename cell_type> concept CellOrView = std::is_same_v<cell_type, cell_t> || std::is_same_v<cell_type, cell_view_t>;
+
+    template <CellOrView cell_type> inline bool is_empty(const cell_type& cell)
     {
         return std::visit(
             []<typename Content>(const Content&) {
@@ -37,7 +46,7 @@ namespace acmacs::sheet::inline v1
             cell);
     }
 
-    inline bool is_date(const cell_t& cell)
+    template <CellOrView cell_type> inline bool is_date(const cell_type& cell)
     {
         return std::visit(
             []<typename Content>(const Content&) {
@@ -49,11 +58,11 @@ namespace acmacs::sheet::inline v1
             cell);
     }
 
-    inline bool is_string(const cell_t& cell)
+    template <CellOrView cell_type> inline bool is_string(const cell_type& cell)
     {
         return std::visit(
             []<typename Content>(const Content&) {
-                if constexpr (std::is_same_v<Content, std::string>)
+                if constexpr (std::is_same_v<Content, std::string> || std::is_same_v<Content, std::string_view>)
                     return true;
                 else
                     return false;
@@ -110,36 +119,148 @@ namespace acmacs::sheet::inline v1
     using row_range = range<nrow_t>;
     using column_range = range<ncol_t>;
 
+    // longest run of consecutive columns for which pred(col) is true, empty range if none
+    template <typename Pred> column_range longest_column_range(ncol_t number_of_columns, Pred pred)
+    {
+        column_range longest;
+        column_range current;
+        const auto update = [&longest, &current] {
+            if (current.valid()) {
+                if (!longest.valid() || longest.length() < current.length())
+                    longest = current;
+                current = column_range{};
+            }
+        };
+
+        for (auto col = ncol_t{0}; col < number_of_columns; ++col) {
+            if (pred(col)) {
+                if (!current.valid())
+                    current.first = col;
+                current.second = col;
+            }
+            else
+                update();
+        }
+        update();
+        return longest;
+    }
+
+    // rows and columns having at least one non-empty cell (empty strings are empty)
+    struct occupancy_t
+    {
+        std::vector<bool> rows;
+        std::vector<bool> columns;
+
+        bool row(nrow_t row) const { return *row < rows.size() && rows[*row]; }
+        bool column(ncol_t col) const { return *col < columns.size() && columns[*col]; }
+    };
+
+    // text of a string cell as used by the text index: trimmed, upper-cased, whitespace runs replaced with single space
+    std::string normalize_label(std::string_view text);
+
+    // anchored case insensitive label regex, e.g. "^\\s*LOT\\s*#?\\s*$"
+    // if the pattern is a plain text with optional chars and \s* \s+ \s, all normalized texts it can match are enumerated
+    // and Sheet::grep() looks them up in the sheet text index instead of scanning cells
+    class anchored_label_t
+    {
+      public:
+        anchored_label_t(const char* pattern, std::regex::flag_type flags = acmacs::regex::icase);
+
+        const std::regex& regex() const { return regex_; }
+        operator const std::regex&() const { return regex_; }
+        bool indexable() const { return !keys_.empty(); }
+        const std::vector<std::string>& keys() const { return keys_; } // normalized texts the pattern matches, empty if not indexable
+
+      private:
+        std::regex regex_;
+        std::vector<std::string> keys_;
+    };
+
+    // compile time matcher of cell text used instead of std::regex, see anchor-lexer.hh
+    using text_matcher_t = bool (*)(std::string_view);
+
+    using text_index_t = std::unordered_map<std::string, std::vector<cell_addr_t>>; // normalize_label(string cell) -> cells in row-major order
+
+    // smaller sheets cannot have antigens and sera, extractor_factory() ignores them
+    constexpr const nrow_t minimal_number_of_rows{5};
+    constexpr const ncol_t minimal_number_of_columns{5};
+
+    bool is_ignored_sheet_name(std::string_view name); // sheet name starts with AC-IGNORE
+
+    // sheet metadata available without reading cells
+    struct sheet_info_t
+    {
+        std::string name;
+        std::optional<cell_addr_t> dimension{}; // number of rows and columns recorded in the file (xlsx <dimension ref>), trailing empty cells included
+
+        std::string_view ignore_reason() const; // empty if sheet cannot be rejected before reading its cells
+    };
+
+    class cell_grid_t;
+    template <NRowCol index_t> class cell_span_t;
+    using row_span_t = cell_span_t<ncol_t>;    // cells of a row, indexed by column
+    using column_span_t = cell_span_t<nrow_t>; // cells of a column, indexed by row
+
     class Sheet
     {
       public:
-        virtual ~Sheet() = default;
+        virtual ~Sheet();
 
         virtual std::string name() const = 0;
         virtual nrow_t number_of_rows() const = 0;
         virtual ncol_t number_of_columns() const = 0;
         virtual cell_t cell(nrow_t row, ncol_t col) const = 0;                               // row and col are zero based
+        virtual cell_view_t cell_view(nrow_t row, ncol_t col) const;                         // row and col are zero based, strings are kept by the sheet
         // virtual cell_spans_t cell_spans(nrow_t /*row*/, ncol_t /*col*/) const { return {}; } // row and col are zero based
 
-        static bool matches(const std::regex& re, const cell_t& cell);
-        static bool matches(const std::regex& re, std::smatch& match, const cell_t& cell);
-        bool matches(const std::regex& re, nrow_t row, ncol_t col) const { return matches(re, cell(row, col)); }
-        bool is_date(nrow_t row, ncol_t col) const { return acmacs::sheet::is_date(cell(row, col)); }
-        size_t size(const cell_t& cell) const;
-        size_t size(nrow_t row, ncol_t col) const { return size(cell(row, col)); }
-
-        bool maybe_titer(const cell_t& cell) const;
-        bool maybe_titer(nrow_t row, ncol_t col) const { return maybe_titer(cell(row, col)); }
+        // whole rows and columns without virtual call per cell
+        virtual const cell_grid_t& grid() const; // sheet is materialized on the first use, backends keeping cell_grid_t override
+        row_span_t row(nrow_t row) const;
+        column_span_t column(ncol_t col) const;
+        const occupancy_t& occupancy() const;
+
+        // cell content as text, numbers and dates are formatted once per sheet, empty cell is empty text
+        std::string_view text(nrow_t row, ncol_t col) const;
+
+        static bool matches(const std::regex& re, const cell_view_t& cell);
+        static bool matches(const std::regex& re, std::cmatch& match, const cell_view_t& cell);
+        bool matches(const std::regex& re, nrow_t row, ncol_t col) const; // non-string cells are matched against their text()
+        static bool matches(text_matcher_t matcher, const cell_view_t& cell);
+        bool matches(text_matcher_t matcher, nrow_t row, ncol_t col) const { return matcher(text(row, col)); }
+        bool is_date(nrow_t row, ncol_t col) const { return acmacs::sheet::is_date(cell_view(row, col)); }
+        static size_t size(const cell_view_t& cell);
+        size_t size(nrow_t row, ncol_t col) const { return size(cell_view(row, col)); }
+
+        static bool maybe_titer(const cell_view_t& cell);
+        bool maybe_titer(nrow_t row, ncol_t col) const { return maybe_titer(cell_view(row, col)); }
         column_range titer_range(nrow_t row) const; // returns column range, returns empty range if not found
 
         cell_addr_t min_cell() const { return {nrow_t{0}, ncol_t{0}}; }
         cell_addr_t max_cell() const { return {number_of_rows(), number_of_columns()}; }
 
         std::vector<cell_match_t> grep(const std::regex& rex, const cell_addr_t& min, const cell_addr_t& max) const;
+        std::vector<cell_match_t> grep(text_matcher_t matcher, const cell_addr_t& min, const cell_addr_t& max) const; // string cells only, match 0 is the cell text
+        // scans cells once, returns matches for each of rexes
+        std::vector<std::vector<cell_match_t>> grep_many(const std::vector<const std::regex*>& rexes, const cell_addr_t& min, const cell_addr_t& max) const;
 
         // finds sets of two cells, the second one is right below the the first one
         // returns references to the second cells
         std::vector<cell_match_t> grepv(const std::regex& rex1, const std::regex& rex2, const cell_addr_t& min, const cell_addr_t& max) const;
+
+        // the same as above using text index of the sheet, scans cells if label is not indexable
+        std::vector<cell_match_t> grep(const anchored_label_t& label, const cell_addr_t& min, const cell_addr_t& max) const;
+        std::vector<cell_match_t> grepv(const anchored_label_t& label1, const anchored_label_t& label2, const cell_addr_t& min, const cell_addr_t& max) const;
+        const text_index_t& text_index() const; // built on the first use
+
+      private:
+        // strings of cells returned by the default cell_view(), for backends that do not keep cell content,
+        // and rendered non-string cells returned by text()
+        mutable std::mutex cell_view_strings_access_;
+        mutable std::unordered_map<size_t, std::string> cell_view_strings_;
+        mutable std::once_flag grid_materialized_;
+        mutable std::unique_ptr<cell_grid_t> grid_;
+        mutable std::once_flag text_index_built_;
+        mutable text_index_t text_index_;
     };
 
 } // namespace acmacs::sheet::inline v1
@@ -148,7 +269,7 @@ namespace acmacs::sheet::inline v1
 
 template <> struct fmt::formatter<acmacs::sheet::cell_t> : fmt::formatter<acmacs::fmt_helper::default_formatter>
 {
-    template <typename FormatCtx> auto format(const acmacs::sheet::cell_t& cell, FormatCtx& ctx)
+    template <acmacs::sheet::CellOrView cell_type, typename FormatCtx> auto format(const cell_type& cell, FormatCtx& ctx)
     {
         std::visit(
             [&ctx]<typename Content>(const Content& arg) {
@@ -158,7 +279,7 @@ template <> struct fmt::formatter<acmacs::sheet::cell_t> : fmt::formatter<acmacs
                     fmt::format_to(ctx.out(), "<error>");
                 else if constexpr (std::is_same_v<Content, bool>)
                     fmt::format_to(ctx.out(), "{}", arg);
-                else if constexpr (std::is_same_v<Content, std::string> || std::is_same_v<Content, double> || std::is_same_v<Content, long>)
+                else if constexpr (std::is_same_v<Content, std::string> || std::is_same_v<Content, std::string_view> || std::is_same_v<Content, double> || std::is_same_v<Content, long>)
                     fmt::format_to(ctx.out(), "{}", arg);
                 else if constexpr (std::is_same_v<Content, date::year_month_day>)
                     fmt::format_to(ctx.out(), "{}", date::display(arg));
@@ -170,6 +291,10 @@ template <> struct fmt::formatter<acmacs::sheet::cell_t> : fmt::formatter<acmacs
     }
 };
 
+template <> struct fmt::formatter<acmacs::sheet::cell_view_t> : fmt::formatter<acmacs::sheet::cell_t>
+{
+};
+
 template <> struct fmt::formatter<acmacs::sheet::nrow_t> : fmt::formatter<acmacs::fmt_helper::default_formatter>
 {
     template <typename FormatCtx> auto format(acmacs::sheet::nrow_t row, FormatCtx& ctx)
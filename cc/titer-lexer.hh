@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string_view>
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::sheet::inline v1
+{
+    // Accepts exactly what the former re_titer regex accepted:
+    //   ^\s*(<|>|,|(?:<|>|\xEF\xBC\x9C)?\s*[1-9][0-9]{0,5}|N[DAT]|QNS|\*)\s*$  (case insensitive)
+    // \xEF\xBC\x9C -> "<" unicode Fullwidth Less-Than Sign &#xFF1C; (NIID)
+    // ">" and "," - perhaps typos in Crick tables
+    constexpr bool is_titer(std::string_view src)
+    {
+        constexpr auto is_space = [](char cc) { return cc == ' ' || cc == '\t' || cc == '\n' || cc == '\v' || cc == '\f' || cc == '\r'; };
+        constexpr auto upper = [](char cc) { return (cc >= 'a' && cc <= 'z') ? static_cast<char>(cc - 'a' + 'A') : cc; };
+        constexpr std::string_view fullwidth_less_than{"\xEF\xBC\x9C"};
+
+        size_t first{0}, last{src.size()};
+        while (first < last && is_space(src[first]))
+            ++first;
+        while (last > first && is_space(src[last - 1]))
+            --last;
+        const auto body = src.substr(first, last - first);
+
+        switch (body.size()) {
+            case 0:
+                return false;
+            case 1:
+                if (body[0] == '<' || body[0] == '>' || body[0] == ',' || body[0] == '*')
+                    return true;
+                break;
+            case 2:
+                if (upper(body[0]) == 'N' && (upper(body[1]) == 'D' || upper(body[1]) == 'A' || upper(body[1]) == 'T'))
+                    return true;
+                break;
+            case 3:
+                if (upper(body[0]) == 'Q' && upper(body[1]) == 'N' && upper(body[2]) == 'S')
+                    return true;
+                break;
+        }
+
+        // optional prefix, optional spaces, 1-6 digits without leading zero
+        size_t pos{0};
+        if (body[0] == '<' || body[0] == '>')
+            pos = 1;
+        else if (body.substr(0, fullwidth_less_than.size()) == fullwidth_less_than)
+            pos = fullwidth_less_than.size();
+        if (pos > 0) {
+            while (pos < body.size() && is_space(body[pos]))
+                ++pos;
+        }
+        if (pos == body.size() || body[pos] < '1' || body[pos] > '9' || (body.size() - pos) > 6)
+            return false;
+        for (++pos; pos < body.size(); ++pos) {
+            if (body[pos] < '0' || body[pos] > '9')
+                return false;
+        }
+        return true;
+    }
+
+    static_assert(is_titer("40") && is_titer(" <10 ") && is_titer("< 10") && is_titer(">5120") && is_titer("\xEF\xBC\x9C""10") && is_titer("\xEF\xBC\x9C 10"));
+    static_assert(is_titer("<") && is_titer(">") && is_titer(",") && is_titer("*") && is_titer("nd") && is_titer("NA") && is_titer("Nt") && is_titer("qns") && is_titer("999999"));
+    static_assert(!is_titer("") && !is_titer(" ") && !is_titer("0") && !is_titer("010") && !is_titer("1234567") && !is_titer("<<10") && !is_titer("10<") && !is_titer("1 0") && !is_titer("N") && !is_titer("NDA") && !is_titer("**"));
+
+} // namespace acmacs::sheet::inline v1
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,541 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <numeric>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "acmacs-base/argv.hh"
+#include "acmacs-base/date.hh"
+#include "acmacs-base/read-file.hh"
+#include "acmacs-whocc/log.hh"
+#include "acmacs-whocc/csv-parser.hh"
+
+// ----------------------------------------------------------------------
+// CDC tsv export (one titer per row, rows of a test share test_id) to ace
+// tables, streaming counterpart of bin/whocc-cdc-tsv-tables-to-ace. Rows
+// are read in groups by test_id. The input is read twice: the first pass
+// finds the last test of each test date, in the second pass a table is
+// written right after the last test of its date, i.e. only tables of the
+// dates with tests still ahead are kept in memory and a table is never
+// split even if tests of a date are not adjacent.
+// ----------------------------------------------------------------------
+
+namespace
+{
+    using record_t = acmacs::xlsx::csv::grouped_records_t::record_t;
+
+    // columns of the export, used ones are listed in fields_t, others are ignored; unknown columns are errors
+    constexpr const std::array known_columns{
+        "test_id",           "test_date",          "test_file",          "test_protocol",    "test_subtype",     "ag_isl_type",      "ag_ha_type",        "sr_isl_type",
+        "sr_ha_type",        "ag_position",        "ag_entry_id",        "ag_cdc_id",        "ag_isolate_id",    "ag_epi_isolate_id", "ag_strain_name",   "ag_passage",
+        "ag_seq_passage",    "ag_collection_date", "ag_date_harvested",  "ag_lab",           "ag_type",          "ag_is_homologous", "ag_do_not_report",  "ag_back_titer",
+        "ag_entry_error",    "ag_pairing_status",  "ag_test_for_fra",    "sr_position",      "sr_entry_id",      "sr_cdc_id",        "sr_isolate_id",     "sr_epi_isolate_id",
+        "sr_strain_name",    "sr_lot",             "sr_ferret",          "sr_passage",       "sr_seq_passage",   "sr_collection_date", "sr_date_harvested", "sr_boosted",
+        "sr_lab",            "sr_pool",            "sr_do_not_report",   "sr_pairing_status", "titer_reportable", "titer_error",      "titer_value",       "titer_log",
+        "titer_logfold"};
+
+    struct fields_t
+    {
+        fields_t(const acmacs::xlsx::csv::grouped_records_t& reader)
+        {
+            for (const auto& name : reader.header()) {
+                if (std::find(std::begin(known_columns), std::end(known_columns), name) == std::end(known_columns))
+                    throw std::runtime_error{fmt::format("Unrecognized source field {}", name)};
+            }
+            const auto column = [&reader](std::string_view name) {
+                if (const auto col = reader.column(name); col.has_value())
+                    return *col;
+                throw std::runtime_error{fmt::format("no \"{}\" column", name)};
+            };
+            test_date = column("test_date");
+            test_protocol = column("test_protocol");
+            test_subtype = column("test_subtype");
+            ag_cdc_id = column("ag_cdc_id");
+            ag_strain_name = column("ag_strain_name");
+            ag_passage = column("ag_passage");
+            ag_collection_date = column("ag_collection_date");
+            ag_date_harvested = column("ag_date_harvested");
+            sr_strain_name = column("sr_strain_name");
+            sr_lot = column("sr_lot");
+            sr_passage = column("sr_passage");
+            sr_date_harvested = column("sr_date_harvested");
+            sr_boosted = column("sr_boosted");
+            titer_value = column("titer_value");
+        }
+
+        size_t test_date, test_protocol, test_subtype, ag_cdc_id, ag_strain_name, ag_passage, ag_collection_date, ag_date_harvested, sr_strain_name, sr_lot, sr_passage, sr_date_harvested, sr_boosted,
+            titer_value;
+    };
+
+    // ----------------------------------------------------------------------
+
+    inline std::string_view strip(std::string_view src)
+    {
+        while (!src.empty() && std::isspace(static_cast<unsigned char>(src.front())))
+            src.remove_prefix(1);
+        while (!src.empty() && std::isspace(static_cast<unsigned char>(src.back())))
+            src.remove_suffix(1);
+        return src;
+    }
+
+    inline std::string upper(std::string_view src)
+    {
+        std::string result{src};
+        std::transform(std::begin(result), std::end(result), std::begin(result), [](char cc) { return static_cast<char>(std::toupper(static_cast<unsigned char>(cc))); });
+        return result;
+    }
+
+    inline bool is_true(std::string_view field, std::string_view column_name)
+    {
+        const auto value = upper(field);
+        if (value == "TRUE")
+            return true;
+        if (value != "FALSE")
+            throw std::runtime_error{fmt::format("Unrecognized \"{}\" value: \"{}\"", column_name, field)};
+        return false;
+    }
+
+    // %Y-%m-%d, %m/%d/%Y, %m/%d/%y, %d/%m/%Y, %d/%m/%y tried in this order, as the python script does
+    inline date::year_month_day convert_date(std::string_view field)
+    {
+        const auto number = [](std::string_view src) -> std::optional<unsigned> {
+            unsigned result{0};
+            if (src.empty() || std::from_chars(src.data(), src.data() + src.size(), result).ptr != src.data() + src.size())
+                return std::nullopt;
+            return result;
+        };
+        const auto make = [](std::string_view year_s, std::optional<unsigned> year, std::optional<unsigned> month, std::optional<unsigned> day) -> std::optional<date::year_month_day> {
+            if (!year || !month || !day || (year_s.size() != 4 && year_s.size() != 2))
+                return std::nullopt;
+            if (year_s.size() == 2)
+                *year += *year < 69 ? 2000 : 1900;
+            if (const date::year_month_day result{date::year{static_cast<int>(*year)}, date::month{*month}, date::day{*day}}; result.ok())
+                return result;
+            return std::nullopt;
+        };
+
+        const char separator = field.find('/') != std::string_view::npos ? '/' : '-';
+        std::array<std::string_view, 3> parts;
+        size_t start{0};
+        for (size_t part_no = 0; part_no < parts.size(); ++part_no) {
+            const auto end = part_no < 2 ? field.find(separator, start) : field.size();
+            if (end == std::string_view::npos)
+                throw std::runtime_error{fmt::format("Cannot parse date from \"{}\"", field)};
+            parts[part_no] = field.substr(start, end - start);
+            start = end + 1;
+        }
+        std::optional<date::year_month_day> result;
+        if (separator == '-') {
+            if (parts[0].size() == 4)
+                result = make(parts[0], number(parts[0]), number(parts[1]), number(parts[2]));
+        }
+        else if (result = make(parts[2], number(parts[2]), number(parts[0]), number(parts[1])); !result)
+            result = make(parts[2], number(parts[2]), number(parts[1]), number(parts[0]));
+        if (!result)
+            throw std::runtime_error{fmt::format("Cannot parse date from \"{}\"", field)};
+        return *result;
+    }
+
+    inline std::string format_date(const date::year_month_day& src, std::string_view separator)
+    {
+        return fmt::format("{:04d}{}{:02d}{}{:02d}", static_cast<int>(src.year()), separator, static_cast<unsigned>(src.month()), separator, static_cast<unsigned>(src.day()));
+    }
+
+    // ([><])?(\d+(?:\.\d*)?) rounded, "5" is "<10"
+    inline std::string check_titer(std::string_view titer)
+    {
+        if (titer == "5")
+            return "<10";
+        std::string_view prefix;
+        if (!titer.empty() && (titer[0] == '<' || titer[0] == '>')) {
+            prefix = titer.substr(0, 1);
+            titer.remove_prefix(1);
+        }
+        const auto dot = titer.find('.');
+        const auto integral = titer.substr(0, dot);
+        const auto fractional = dot == std::string_view::npos ? std::string_view{} : titer.substr(dot + 1);
+        const auto all_digits = [](std::string_view src) { return std::all_of(std::begin(src), std::end(src), [](char cc) { return cc >= '0' && cc <= '9'; }); };
+        if (integral.empty() || !all_digits(integral) || !all_digits(fractional))
+            throw std::runtime_error{fmt::format("Unrecognized titer \"{}{}\"", prefix, titer)};
+        return fmt::format("{}{}", prefix, static_cast<long>(std::nearbyint(std::stod(std::string{titer})))); // nearbyint: round half to even as python round()
+    }
+
+    // runs program found in PATH with arguments, without shell, returns its stdout; throws if it cannot be run or fails
+    inline std::string run(const std::vector<std::string>& args)
+    {
+        std::vector<char*> argv;
+        for (const auto& arg : args)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        std::array<int, 2> output{-1, -1};
+        if (::pipe(output.data()) != 0)
+            throw std::runtime_error{fmt::format("cannot run \"{}\": {}", args.front(), std::strerror(errno))};
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, output[0]);
+        posix_spawn_file_actions_addclose(&actions, output[1]);
+        pid_t pid{0};
+        const auto spawn_error = posix_spawnp(&pid, argv.front(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(output[1]);
+        if (spawn_error != 0) {
+            ::close(output[0]);
+            throw std::runtime_error{fmt::format("cannot run \"{}\": {}", args.front(), std::strerror(spawn_error))};
+        }
+
+        std::string result;
+        std::array<char, 256> buffer;
+        for (auto bytes = ::read(output[0], buffer.data(), buffer.size()); bytes != 0; bytes = ::read(output[0], buffer.data(), buffer.size())) {
+            if (bytes > 0)
+                result.append(buffer.data(), static_cast<size_t>(bytes));
+            else if (errno != EINTR)
+                break;
+        }
+        ::close(output[0]);
+
+        int status{0};
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            ;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error{fmt::format("\"{}\" failed", std::accumulate(std::next(std::begin(args)), std::end(args), args.front(), [](std::string cmd, const std::string& arg) { return cmd + ' ' + arg; }))};
+        return result;
+    }
+
+    inline std::string merge_titers(const std::vector<std::string>& titers)
+    {
+        std::vector<std::string> args{"chart-titer-merge"};
+        args.insert(std::end(args), std::begin(titers), std::end(titers));
+        return std::string{strip(run(args))};
+    }
+
+    // ----------------------------------------------------------------------
+
+    struct antigen_t
+    {
+        std::string name, passage, date, lab_id;
+    };
+
+    struct serum_t
+    {
+        std::string name, passage, serum_id;
+        bool boosted{false};
+    };
+
+    struct table_t
+    {
+        std::string name, date, virus_type, lineage, assay;
+        std::vector<antigen_t> antigens;
+        std::vector<serum_t> sera;
+        std::vector<std::vector<std::vector<std::string>>> titers; // [antigen][serum], several titers are merged on output
+
+        size_t antigen_index(antigen_t&& antigen)
+        {
+            if (const auto found = std::find_if(std::begin(antigens), std::end(antigens), [&antigen](const auto& en) { return en.name == antigen.name && en.passage == antigen.passage && en.lab_id == antigen.lab_id; });
+                found != std::end(antigens)) {
+                if (!antigen.date.empty() && found->date != antigen.date)
+                    AD_WARNING("antigen date mismatch: new: \"{}\", old: \"{}\" {} {}", antigen.date, found->date, found->name, found->passage);
+                return static_cast<size_t>(found - std::begin(antigens));
+            }
+            antigens.push_back(std::move(antigen));
+            return antigens.size() - 1;
+        }
+
+        size_t serum_index(serum_t&& serum)
+        {
+            if (const auto found = std::find_if(std::begin(sera), std::end(sera), [&serum](const auto& en) { return en.name == serum.name && en.serum_id == serum.serum_id && en.boosted == serum.boosted; });
+                found != std::end(sera)) {
+                if (found->passage != serum.passage)
+                    AD_WARNING("serum passage mismatch: new: \"{}\", old: \"{}\" {} {}", serum.passage, found->passage, found->name, found->serum_id);
+                return static_cast<size_t>(found - std::begin(sera));
+            }
+            sera.push_back(std::move(serum));
+            return sera.size() - 1;
+        }
+
+        void add_titer(size_t ag_no, size_t sr_no, std::string&& titer)
+        {
+            if (titers.size() <= ag_no)
+                titers.resize(ag_no + 1);
+            if (titers[ag_no].size() <= sr_no)
+                titers[ag_no].resize(sr_no + 1);
+            titers[ag_no][sr_no].push_back(std::move(titer));
+        }
+    };
+
+    // ----------------------------------------------------------------------
+
+    inline std::string test_date(const record_t& record, const fields_t& fields)
+    {
+        return format_date(convert_date(strip(record[fields.test_date])), "");
+    }
+
+    inline void add_row(std::map<std::string, table_t>& tables, const record_t& record, const fields_t& fields)
+    {
+        std::string assay, virus_type, virus_type_low, lineage;
+        const auto protocol = strip(record[fields.test_protocol]);
+        if (protocol == "hi_protocol" || protocol == "hi_oseltamivir_protocol")
+            assay = "HI";
+        else if (protocol == "fra_protocol")
+            assay = "FRA";
+        else if (protocol == "hint_protocol")
+            assay = "HINT";
+        else
+            throw std::runtime_error{fmt::format("Unrecognized test protocol: \"{}\"", protocol)};
+
+        const auto subtype = strip(record[fields.test_subtype]);
+        if (subtype == "H1 swl") {
+            virus_type = "A(H1N1)";
+            virus_type_low = "h1pdm";
+        }
+        else if (subtype == "H3") {
+            virus_type = "A(H3N2)";
+            virus_type_low = "h3";
+        }
+        else if (subtype == "B") {
+            virus_type = "B";
+            virus_type_low = "b";
+        }
+        else if (subtype == "B vic") {
+            virus_type = "B";
+            virus_type_low = "bvic";
+            lineage = "VICTORIA";
+        }
+        else if (subtype == "B yam") {
+            virus_type = "B";
+            virus_type_low = "byam";
+            lineage = "YAMAGATA";
+        }
+        else
+            throw std::runtime_error{fmt::format("Unrecognized test_subtype: \"{}\"", subtype)};
+
+        std::string assay_rbc{assay == "HI" ? (virus_type_low == "h3" ? "hi-guinea-pig" : "hi-turkey") : assay};
+        std::transform(std::begin(assay_rbc), std::end(assay_rbc), std::begin(assay_rbc), [](char cc) { return static_cast<char>(std::tolower(static_cast<unsigned char>(cc))); });
+        const auto date = test_date(record, fields);
+        const auto table_name = fmt::format("{}-{}-cdc-{}", virus_type_low, assay_rbc, date);
+        auto [table_it, inserted] = tables.try_emplace(table_name);
+        auto& table = table_it->second;
+        if (inserted) {
+            table.name = table_name;
+            table.date = date;
+            table.virus_type = virus_type;
+            table.lineage = lineage;
+            table.assay = assay;
+        }
+
+        const auto passage = [&record](size_t passage_col, size_t harvested_col) {
+            if (const auto harvested = strip(record[harvested_col]); !harvested.empty() && harvested != "None")
+                return fmt::format("{} ({})", strip(record[passage_col]), format_date(convert_date(harvested), "-"));
+            return std::string{strip(record[passage_col])};
+        };
+        const auto ag_no = table.antigen_index(antigen_t{.name = upper(strip(record[fields.ag_strain_name])),
+                                                         .passage = passage(fields.ag_passage, fields.ag_date_harvested),
+                                                         .date = format_date(convert_date(strip(record[fields.ag_collection_date])), "-"),
+                                                         .lab_id = fmt::format("CDC#{}", strip(record[fields.ag_cdc_id]))});
+        const auto sr_no = table.serum_index(serum_t{.name = upper(strip(record[fields.sr_strain_name])),
+                                                     .passage = passage(fields.sr_passage, fields.sr_date_harvested),
+                                                     .serum_id = fmt::format("CDC {}", strip(record[fields.sr_lot])),
+                                                     .boosted = is_true(strip(record[fields.sr_boosted]), "sr_boosted")});
+        table.add_titer(ag_no, sr_no, check_titer(strip(record[fields.titer_value])));
+    }
+
+    // ----------------------------------------------------------------------
+
+    inline std::string json_string(std::string_view src)
+    {
+        std::string result{"\""};
+        for (const char cc : src) {
+            switch (cc) {
+                case '"':
+                    result.append("\\\"");
+                    break;
+                case '\\':
+                    result.append("\\\\");
+                    break;
+                case '\n':
+                    result.append("\\n");
+                    break;
+                case '\t':
+                    result.append("\\t");
+                    break;
+                default:
+                    if (static_cast<unsigned char>(cc) < 0x20)
+                        result.append(fmt::format("\\u{:04x}", static_cast<unsigned>(cc)));
+                    else
+                        result.push_back(cc);
+                    break;
+            }
+        }
+        result.push_back('"');
+        return result;
+    }
+
+    // titers merged, missing titers are "*", antigens sorted as the python script does
+    inline std::string make_ace(const table_t& table, std::string_view created)
+    {
+        std::vector<std::string> titer_rows(table.antigens.size());
+        for (size_t ag_no = 0; ag_no < table.antigens.size(); ++ag_no) {
+            std::vector<std::string> row(table.sera.size(), "*");
+            if (ag_no < table.titers.size()) {
+                for (size_t sr_no = 0; sr_no < table.titers[ag_no].size(); ++sr_no) {
+                    const auto& titers = table.titers[ag_no][sr_no];
+                    if (titers.empty())
+                        continue;
+                    row[sr_no] = titers.size() == 1 ? titers.front() : merge_titers(titers);
+                    if (const auto& titer = row[sr_no]; !titer.empty() && titer[0] != '*' && titer[0] != '<' && titer[0] != '>' && std::stol(titer) < 10) {
+                        AD_WARNING("{}: invalid titer {} for ag:{} sr:{}", table.name, titer, ag_no, sr_no);
+                        if (std::stol(titer) == 0)
+                            row[sr_no] = "*";
+                    }
+                }
+            }
+            auto& titer_row = titer_rows[ag_no];
+            for (const auto& titer : row)
+                titer_row.append(fmt::format("{}{}", titer_row.empty() ? "[" : ",", json_string(titer)));
+            titer_row.append(titer_row.empty() ? "[]" : "]");
+        }
+
+        std::map<std::string_view, size_t> serum_names;
+        for (size_t sr_no = 0; sr_no < table.sera.size(); ++sr_no)
+            serum_names[table.sera[sr_no].name] = sr_no;
+        std::vector<std::string> sort_keys(table.antigens.size());
+        for (size_t ag_no = 0; ag_no < table.antigens.size(); ++ag_no) {
+            const auto& antigen = table.antigens[ag_no];
+            const auto found = serum_names.find(antigen.name);
+            sort_keys[ag_no] = fmt::format("{:03d}-{}-{}-", found != serum_names.end() ? found->second : 999ul, antigen.date.empty() ? std::string_view{"9999"} : std::string_view{antigen.date}, antigen.name);
+        }
+        std::vector<size_t> order(table.antigens.size());
+        std::iota(std::begin(order), std::end(order), 0ul);
+        std::stable_sort(std::begin(order), std::end(order), [&sort_keys](size_t a1, size_t a2) { return sort_keys[a1] < sort_keys[a2]; });
+
+        fmt::memory_buffer out;
+        fmt::format_to(std::back_inserter(out), "{{\"  version\": \"acmacs-ace-v1\",\n \"?created\": {},\n \"c\": {{\n  \"i\": {{\"l\": \"CDC\", \"D\": {}, \"V\": {}, \"A\": {}", json_string(created), json_string(table.date),
+                       json_string(table.virus_type), json_string(table.assay));
+        if (table.assay == "HI")
+            fmt::format_to(std::back_inserter(out), ", \"r\": \"turkey\"");
+        if (!table.lineage.empty())
+            fmt::format_to(std::back_inserter(out), ", \"s\": {}", json_string(table.lineage));
+        fmt::format_to(std::back_inserter(out), "}},\n  \"a\": [");
+        for (size_t no = 0; no < order.size(); ++no) {
+            const auto& antigen = table.antigens[order[no]];
+            fmt::format_to(std::back_inserter(out), "{}\n   {{\"N\": {}, \"P\": {}", no ? "," : "", json_string(antigen.name), json_string(antigen.passage));
+            if (!antigen.date.empty())
+                fmt::format_to(std::back_inserter(out), ", \"D\": {}", json_string(antigen.date));
+            if (!table.lineage.empty())
+                fmt::format_to(std::back_inserter(out), ", \"L\": {}", json_string(table.lineage));
+            fmt::format_to(std::back_inserter(out), ", \"l\": [{}]}}", json_string(antigen.lab_id));
+        }
+        fmt::format_to(std::back_inserter(out), "\n  ],\n  \"s\": [");
+        for (size_t sr_no = 0; sr_no < table.sera.size(); ++sr_no) {
+            const auto& serum = table.sera[sr_no];
+            fmt::format_to(std::back_inserter(out), "{}\n   {{\"N\": {}, \"P\": {}, \"I\": {}", sr_no ? "," : "", json_string(serum.name), json_string(serum.passage), json_string(serum.serum_id));
+            if (!table.lineage.empty())
+                fmt::format_to(std::back_inserter(out), ", \"L\": {}", json_string(table.lineage));
+            if (serum.boosted)
+                fmt::format_to(std::back_inserter(out), ", \"a\": [\"BOOSTED\"]");
+            fmt::format_to(std::back_inserter(out), "}}");
+        }
+        fmt::format_to(std::back_inserter(out), "\n  ],\n  \"t\": {{\"l\": [");
+        for (size_t no = 0; no < order.size(); ++no)
+            fmt::format_to(std::back_inserter(out), "{}\n    {}", no ? "," : "", titer_rows[order[no]]);
+        fmt::format_to(std::back_inserter(out), "\n  ]}}\n }}\n}}\n");
+        return fmt::to_string(out);
+    }
+
+} // namespace
+
+// ----------------------------------------------------------------------
+
+using namespace acmacs::argv;
+struct Options : public argv
+{
+    Options(int a_argc, const char* const a_argv[], on_error on_err = on_error::exit) : argv() { parse(a_argc, a_argv, on_err); }
+
+    option<str> output_dir{*this, 'o', dflt{"."}, desc{"output directory, tables are written to {output-dir}/{table-name-without-date}/{table-name}.ace"}};
+    option<bool> no_output{*this, 'n', "no-output", desc{"do not write output tables"}};
+    option<bool> no_fix{*this, "no-fix-names-passages", desc{"do not run chart-fix-names-passages on the written tables"}};
+    option<str_array> verbose{*this, 'v', "verbose", desc{"comma separated list (or multiple switches) of log enablers"}};
+
+    argument<str> input{*this, arg_name{".tsv[.xz]"}, mandatory};
+};
+
+int main(int argc, char* const argv[])
+{
+    int exit_code = 0;
+    try {
+        Options opt(argc, argv);
+        acmacs::log::enable(opt.verbose);
+
+        const std::chrono::year_month_day today{std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now())};
+        const auto created = fmt::format("imported from {} by {} on {}-{:02d}-{:02d}", std::filesystem::path{std::string{*opt.input}}.filename().native(),
+                                         std::filesystem::path{argv[0]}.filename().native(), static_cast<int>(today.year()), static_cast<unsigned>(today.month()), static_cast<unsigned>(today.day()));
+
+        std::vector<record_t> group;
+
+        // first pass: number of the last test (group) of each test date
+        std::map<std::string, size_t> last_test_of_date;
+        {
+            acmacs::xlsx::csv::grouped_records_t scanner{*opt.input, "test_id", acmacs::xlsx::csv::format_from_filename(*opt.input)};
+            const fields_t fields{scanner};
+            for (size_t test_no = 0; scanner.next(group); ++test_no) {
+                for (const auto& record : group)
+                    last_test_of_date[test_date(record, fields)] = test_no;
+            }
+        }
+
+        acmacs::xlsx::csv::grouped_records_t reader{*opt.input, "test_id", acmacs::xlsx::csv::format_from_filename(*opt.input)};
+        const fields_t fields{reader};
+
+        std::map<std::string, table_t> tables; // tables of the dates with tests still ahead
+        size_t number_of_tables{0};
+        const auto write = [&](table_t& table) {
+            AD_INFO("{:25s}   a:{:3d}   s:{:3d}", table.name, table.antigens.size(), table.sera.size());
+            ++number_of_tables;
+            if (opt.no_output)
+                return;
+            const auto filename = std::filesystem::path{std::string{*opt.output_dir}} / table.name.substr(0, table.name.size() - 9) / fmt::format("{}.ace", table.name);
+            std::filesystem::create_directories(filename.parent_path());
+            // always xz compressed as by the python script, .ace name does not imply compression
+            acmacs::file::write(filename.native(), make_ace(table, created), acmacs::file::force_compression::yes, acmacs::file::backup_file::no);
+            if (!opt.no_fix)
+                run({"chart-fix-names-passages", filename.native(), filename.native()});
+        };
+
+        for (size_t test_no = 0; reader.next(group); ++test_no) {
+            for (const auto& record : group)
+                add_row(tables, record, fields);
+            // tables of the dates having no more tests are complete
+            for (auto table = std::begin(tables); table != std::end(tables);) {
+                if (last_test_of_date.at(table->second.date) == test_no) {
+                    write(table->second);
+                    table = tables.erase(table);
+                }
+                else
+                    ++table;
+            }
+        }
+        for (auto& [name, table] : tables)
+            write(table);
+
+        AD_INFO("rows: {}", reader.records_read());
+        AD_INFO("tables: {}", number_of_tables);
+    }
+    catch (std::exception& err) {
+        AD_ERROR("{}", err);
+        exit_code = 2;
+    }
+    return exit_code;
+}
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
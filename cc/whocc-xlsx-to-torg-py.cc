@@ -1,4 +1,6 @@
 #include <limits>
+#include <mutex>
+#include <unordered_map>
 
 #include "acmacs-base/log.hh"
 #include "acmacs-whocc/whocc-xlsx-to-torg-py.hh"
@@ -58,6 +60,27 @@ PYBIND11_EMBEDDED_MODULE(data_fix_builtin_module, mdl)
 
 // ----------------------------------------------------------------------
 
+// detect scripts grep with the same few patterns in every sheet, each pattern is compiled once
+static const std::regex& cached_regex(const std::string& pattern)
+{
+    static std::mutex access;
+    static std::unordered_map<std::string, std::regex> cache;
+
+    std::unique_lock lock{access};
+    if (const auto found = cache.find(pattern); found != cache.end())
+        return found->second;
+    return cache.emplace(pattern, std::regex(pattern, acmacs::regex::icase)).first->second;
+}
+
+// python passes last row and col to look in, max_row_col means up to the end
+static acmacs::sheet::cell_addr_t grep_max_cell(const acmacs::sheet::Sheet& sheet, size_t max_row, size_t max_col)
+{
+    using namespace acmacs::sheet;
+    return {max_row == max_row_col ? sheet.number_of_rows() : nrow_t{max_row + 1}, max_col == max_row_col ? sheet.number_of_columns() : ncol_t{max_col + 1}};
+}
+
+// ----------------------------------------------------------------------
+
 PYBIND11_EMBEDDED_MODULE(xlsx_access_builtin_module, mdl)
 {
     using namespace pybind11::literals;
@@ -69,23 +92,25 @@ PYBIND11_EMBEDDED_MODULE(xlsx_access_builtin_module, mdl)
         .def("number_of_columns", [](const Sheet& sheet) { return *sheet.number_of_columns(); }) //
 
         .def(
-            "cell_as_str", [](const Sheet& sheet, size_t row, size_t column) { return fmt::format("{}", sheet.cell(nrow_t{row}, ncol_t{column})); }, "row"_a, "column"_a) //
+            "cell_as_str", [](const Sheet& sheet, size_t row, size_t column) { return std::string{sheet.text(nrow_t{row}, ncol_t{column})}; }, "row"_a, "column"_a) //
 
         .def(
             "grep",
             [](const Sheet& sheet, const std::string& rex, size_t min_row, size_t max_row, size_t min_col, size_t max_col) {
-                if (max_row == max_row_col)
-                    max_row = *sheet.number_of_rows();
-                else
-                    ++max_row;
-                if (max_col == max_row_col)
-                    max_col = *sheet.number_of_columns();
-                else
-                    ++max_col;
-                return sheet.grep(std::regex(rex, acmacs::regex::icase), {nrow_t{min_row}, ncol_t{min_col}}, {nrow_t{max_row}, ncol_t{max_col}});
+                return sheet.grep(cached_regex(rex), {nrow_t{min_row}, ncol_t{min_col}}, grep_max_cell(sheet, max_row, max_col));
             },                                                                                                 //
             "regex"_a, "min_row"_a = 0, "max_row"_a = max_row_col, "min_col"_a = 0, "max_col"_a = max_row_col, //
             py::doc("max_row and max_col are the last row and col to look in"))                                //
+
+        .def(
+            "grep_many",
+            [](const Sheet& sheet, const std::vector<std::string>& rexes, size_t min_row, size_t max_row, size_t min_col, size_t max_col) {
+                std::vector<const std::regex*> compiled(rexes.size());
+                std::transform(std::begin(rexes), std::end(rexes), std::begin(compiled), [](const auto& rex) { return &cached_regex(rex); });
+                return sheet.grep_many(compiled, {nrow_t{min_row}, ncol_t{min_col}}, grep_max_cell(sheet, max_row, max_col));
+            },                                                                                                  //
+            "regexes"_a, "min_row"_a = 0, "max_row"_a = max_row_col, "min_col"_a = 0, "max_col"_a = max_row_col, //
+            py::doc("scans cells once, returns list of matches for each regex in regexes\nmax_row and max_col are the last row and col to look in")) //
         ;
 
     py::class_<cell_match_t>(mdl, "cell_match_t") //
@@ -114,6 +139,7 @@ void acmacs::whocc_xlsx::v1::py_init(const std::vector<std::string_view>& script
 
 acmacs::whocc_xlsx::v1::detect_result_t acmacs::whocc_xlsx::v1::py_sheet_detect(std::shared_ptr<acmacs::sheet::Sheet> sheet)
 {
+    py::gil_scoped_acquire gil; // sheets may be converted by threads that do not hold the interpreter lock
     const auto detected = py::globals()["detect"](sheet);
     // AD_DEBUG("detected: {}", detected);
     detect_result_t result;
@@ -1,3 +1,16 @@
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #include "acmacs-base/argv.hh"
 #include "acmacs-base/range-v3.hh"
 #include "acmacs-base/read-file.hh"
@@ -28,6 +41,8 @@ struct Options : public argv
     option<bool> assay_information{*this, 'n', desc{"print assay information fields according to format (-f or --format)"}};
     option<str_array> scripts{*this, 's', desc{"run python script (multiple switches allowed) before processing files"}};
     option<str_array> verbose{*this, 'v', "verbose", desc{"comma separated list (or multiple switches) of log enablers"}};
+    option<str> backend{*this, "backend", desc{"xlsx reader: stream, xlnt, openxlsx (default: ACMACS_XLSX_BACKEND env or stream), ACMACS_XLSX_SNAPSHOT_DIR env enables sheet snapshots"}};
+    option<size_t> jobs{*this, 'j', dflt{1ul}, desc{"number of files processed in parallel (0: hardware concurrency), output and log of each file are reported in the order of files; sheets of a file are extracted in parallel by the threads left to the file"}};
 
     option<size_t> serum_name_row{*this, "serum-name-row", dflt{0ul}, desc{"force serum name row (1 based)"}};
     option<size_t> serum_passage_row{*this, "serum-passage-row", dflt{0ul}, desc{"force serum passage row (1 based)"}};
@@ -36,6 +51,12 @@ struct Options : public argv
     argument<str_array> xlsx{*this, arg_name{".xlsx"}, mandatory};
 };
 
+static int process(std::string_view xlsx, const Options& opt, acmacs::xlsx::backend backend, size_t number_of_threads);
+static int process_in_parallel(const Options& opt, acmacs::xlsx::backend backend, size_t jobs);
+static void copy_and_close(std::FILE* from, std::FILE* to);
+
+// ----------------------------------------------------------------------
+
 int main(int argc, char* const argv[])
 {
     using namespace std::string_view_literals;
@@ -51,42 +72,16 @@ int main(int argc, char* const argv[])
         acmacs::whocc_xlsx::py_init(*opt.scripts);
 #endif
 
-        for (auto& xlsx : opt.xlsx) {
-            try {
-                AD_INFO("Reading {}", xlsx);
-                auto doc = acmacs::xlsx::open(xlsx);
-                for ([[maybe_unused]] auto sheet_no : range_from_0_to(doc.number_of_sheets())) {
-                    auto converter = acmacs::sheet::SheetToTorg{doc.sheet(sheet_no)};
-                    converter.preprocess(opt.assay_information ? acmacs::sheet::Extractor::warn_if_not_found::no : acmacs::sheet::Extractor::warn_if_not_found::yes);
-                    if (*opt.serum_name_row > 0)
-                        converter.extractor().force_serum_name_row(acmacs::sheet::nrow_t{*opt.serum_name_row - 1});
-                    if (*opt.serum_passage_row > 0)
-                        converter.extractor().force_serum_passage_row(acmacs::sheet::nrow_t{*opt.serum_passage_row - 1});
-                    if (*opt.serum_id_row > 0)
-                        converter.extractor().force_serum_id_row(acmacs::sheet::nrow_t{*opt.serum_id_row - 1});
-                    if (converter.valid()) {
-                        // AD_LOG(acmacs::log::xlsx, "Sheet {:2d} {}", sheet_no + 1, converter.name());
-                        if (opt.assay_information) {
-                            fmt::print("{}\n", converter.format_assay_data(opt.format));
-                        }
-                        else {
-                            converter.extractor().report_data_anchors();
-                            converter.extractor().check_export_possibility();
-                            if (opt.output_dir) {
-                                const auto filename = fmt::format("{}/{}.torg", opt.output_dir, converter.format_assay_data(opt.format));
-                                AD_INFO("{}", filename);
-                                acmacs::file::write(filename, converter.torg());
-                            }
-                            else {
-                                fmt::print("\n{}\n\n", converter.torg());
-                            }
-                        }
-                    }
-                }
-            }
-            catch (std::exception& err) {
-                AD_ERROR("{}: {}", xlsx, err);
-                exit_code = 3;
+        const auto backend = opt.backend ? acmacs::xlsx::backend_from_name(*opt.backend) : acmacs::xlsx::backend_from_environment();
+        const auto& files = *opt.xlsx;
+        const auto jobs = std::min(*opt.jobs > 0 ? *opt.jobs : std::max(std::thread::hardware_concurrency(), 1u), files.size());
+
+        if (jobs > 1)
+            exit_code = process_in_parallel(opt, backend, jobs);
+        else {
+            for (const auto& xlsx : files) {
+                if (const auto file_exit_code = process(xlsx, opt, backend, 0); file_exit_code != 0)
+                    exit_code = file_exit_code;
             }
         }
     }
@@ -98,3 +93,278 @@ int main(int argc, char* const argv[])
 }
 
 // ----------------------------------------------------------------------
+
+// sheets are converted one by one where stderr of a thread cannot be redirected
+static inline size_t number_of_threads_for(size_t number_of_sheets, size_t number_of_threads)
+{
+#if defined(__linux__)
+    return std::min(number_of_sheets, number_of_threads);
+#else
+    return number_of_sheets > 0 ? 1 : 0;
+#endif
+}
+
+// ----------------------------------------------------------------------
+
+// output of a sheet, reported in the order of sheets
+struct sheet_output_t
+{
+    std::FILE* log{nullptr}; // messages of the sheet converted by a pool thread, nullptr: messages were written to stderr directly
+    std::string out;         // to stdout
+    std::string torg_filename;
+    std::string torg; // written to torg_filename, if it is not empty
+    std::exception_ptr error{};
+};
+
+static void convert(std::shared_ptr<acmacs::sheet::Sheet> sheet, const Options& opt, size_t number_of_threads, sheet_output_t& output)
+{
+    auto converter = acmacs::sheet::SheetToTorg{sheet};
+    converter.preprocess(opt.assay_information ? acmacs::sheet::Extractor::warn_if_not_found::no : acmacs::sheet::Extractor::warn_if_not_found::yes, number_of_threads);
+    if (*opt.serum_name_row > 0)
+        converter.extractor().force_serum_name_row(acmacs::sheet::nrow_t{*opt.serum_name_row - 1});
+    if (*opt.serum_passage_row > 0)
+        converter.extractor().force_serum_passage_row(acmacs::sheet::nrow_t{*opt.serum_passage_row - 1});
+    if (*opt.serum_id_row > 0)
+        converter.extractor().force_serum_id_row(acmacs::sheet::nrow_t{*opt.serum_id_row - 1});
+    if (converter.valid()) {
+        // AD_LOG(acmacs::log::xlsx, "Sheet {:2d} {}", sheet_no + 1, converter.name());
+        if (opt.assay_information) {
+            output.out = fmt::format("{}\n", converter.format_assay_data(*opt.format));
+        }
+        else {
+            converter.extractor().report_data_anchors();
+            converter.extractor().check_export_possibility();
+#if defined(ACMACS_USE_PY)
+            py::gil_scoped_acquire gil; // data fixes are registered by python scripts
+#endif
+            if (opt.output_dir) {
+                output.torg_filename = fmt::format("{}/{}.torg", *opt.output_dir, converter.format_assay_data(*opt.format));
+                AD_INFO("{}", output.torg_filename);
+                output.torg = converter.torg();
+            }
+            else {
+                output.out = fmt::format("\n{}\n\n", converter.torg());
+            }
+        }
+    }
+
+} // convert
+
+// ----------------------------------------------------------------------
+
+static void report(sheet_output_t& output)
+{
+    if (output.log) {
+        std::fflush(stdout);
+        copy_and_close(output.log, stderr);
+        output.log = nullptr;
+    }
+    fmt::print("{}", output.out);
+    if (!output.torg_filename.empty())
+        acmacs::file::write(output.torg_filename, output.torg);
+    if (output.error)
+        std::rethrow_exception(output.error);
+
+} // report
+
+// ----------------------------------------------------------------------
+
+// Sheets are converted by a pool of threads, each thread has its own file descriptor table
+// (unshare(CLONE_FILES)) with stderr redirected to the log file of the sheet being converted:
+// messages of the extractors and python scripts are kept per sheet and reported in the order
+// of sheets, sheets after the first failed one are not reported. Python detect functions and
+// data fixes take the interpreter lock, it is released by the calling thread for the duration.
+static void convert_in_parallel(const std::vector<std::shared_ptr<acmacs::sheet::Sheet>>& sheets, const Options& opt, size_t number_of_threads)
+{
+    std::vector<sheet_output_t> outputs(sheets.size());
+    const auto close_logs = [&outputs]() {
+        for (auto& output : outputs) {
+            if (output.log)
+                std::fclose(output.log);
+        }
+    };
+    for (auto& output : outputs) {
+        if (output.log = std::tmpfile(); output.log == nullptr) { // before the pool threads copy the descriptor table
+            close_logs();
+            throw std::runtime_error{fmt::format("cannot create temporary file: {}", std::strerror(errno))};
+        }
+    }
+
+    const size_t pool_size = number_of_threads_for(sheets.size(), number_of_threads);
+    const size_t threads_per_sheet = std::max(number_of_threads / pool_size, 1ul); // for classify_cells of the sheet
+    std::atomic<size_t> next{0};
+    const auto worker = [&sheets, &opt, &outputs, &next, threads_per_sheet]() {
+#if defined(__linux__)
+        if (::unshare(CLONE_FILES) != 0)
+            throw std::runtime_error{fmt::format("unshare failed: {}", std::strerror(errno))};
+#endif
+        for (auto index = next++; index < sheets.size(); index = next++) {
+            ::dup2(::fileno(outputs[index].log), STDERR_FILENO); // stderr is unbuffered
+            try {
+                convert(sheets[index], opt, threads_per_sheet, outputs[index]);
+            }
+            catch (...) {
+                outputs[index].error = std::current_exception();
+            }
+        }
+    };
+
+    try {
+        {
+#if defined(ACMACS_USE_PY)
+            py::gil_scoped_release release;
+#endif
+            std::vector<std::future<void>> workers;
+            for (size_t thread_no = 0; thread_no < pool_size; ++thread_no)
+                workers.push_back(std::async(std::launch::async, worker));
+            for (auto& result : workers)
+                result.get(); // rethrows exception of the worker
+        }
+        for (auto& output : outputs)
+            report(output);
+    }
+    catch (...) {
+        close_logs(); // of the sheets not reported
+        throw;
+    }
+
+} // convert_in_parallel
+
+// ----------------------------------------------------------------------
+
+int process(std::string_view xlsx, const Options& opt, acmacs::xlsx::backend backend, size_t number_of_threads)
+{
+    try {
+        AD_INFO("Reading {}", xlsx);
+        auto doc = acmacs::xlsx::open(xlsx, backend);
+        std::vector<size_t> sheet_nos;
+        for (auto sheet_no : range_from_0_to(doc.number_of_sheets())) {
+            if (const auto info = doc.sheet_info(sheet_no); !info.ignore_reason().empty())
+                AD_INFO("Sheet \"{}\": {}", info.name, info.ignore_reason());
+            else
+                sheet_nos.push_back(sheet_no);
+        }
+        doc.read_sheets(sheet_nos, number_of_threads);
+        std::vector<std::shared_ptr<acmacs::sheet::Sheet>> sheets(sheet_nos.size());
+        std::transform(std::begin(sheet_nos), std::end(sheet_nos), std::begin(sheets), [&doc](size_t sheet_no) { return doc.sheet(sheet_no); });
+
+        if (number_of_threads == 0)
+            number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        if (number_of_threads_for(sheets.size(), number_of_threads) > 1)
+            convert_in_parallel(sheets, opt, number_of_threads);
+        else {
+            for (const auto& sheet : sheets) {
+                sheet_output_t output;
+                convert(sheet, opt, number_of_threads, output);
+                report(output);
+            }
+        }
+        return 0;
+    }
+    catch (std::exception& err) {
+        AD_ERROR("{}: {}", xlsx, err);
+        return 3;
+    }
+
+} // process
+
+// ----------------------------------------------------------------------
+
+// Each file is processed by a worker process forked after scripts are loaded: log messages are
+// written to stderr directly from the extractors and python detect functions hold the interpreter
+// lock, worker processes neither interleave their logs nor wait for each other's python calls.
+// Output and log of a worker are kept in temporary files and reported in the order of files.
+// Threads of the machine are divided between workers, a worker reads and converts sheets of its
+// file with its share (see convert_in_parallel).
+int process_in_parallel(const Options& opt, acmacs::xlsx::backend backend, size_t jobs)
+{
+    struct worker_t
+    {
+        pid_t pid{0};
+        std::FILE* out{nullptr};
+        std::FILE* err{nullptr};
+        int exit_code{0};
+        int signal{0};
+        bool finished{false};
+    };
+
+    const auto& files = *opt.xlsx;
+    const size_t threads_per_worker = std::max(std::thread::hardware_concurrency() / jobs, 1ul); // sheets of a file are read and converted concurrently
+    std::vector<worker_t> workers(files.size());
+    size_t next_to_start{0}, next_to_report{0}, running{0};
+    int exit_code{0};
+    while (next_to_report < files.size()) {
+        for (; running < jobs && next_to_start < files.size(); ++next_to_start, ++running) {
+            auto& worker = workers[next_to_start];
+            worker.out = std::tmpfile();
+            worker.err = std::tmpfile();
+            if (worker.out == nullptr || worker.err == nullptr)
+                throw std::runtime_error{fmt::format("cannot create temporary file: {}", std::strerror(errno))};
+            std::fflush(stdout);
+            std::fflush(stderr);
+#if defined(ACMACS_USE_PY)
+            PyOS_BeforeFork(); // interpreter locks are acquired, the child does not inherit them held by other threads
+#endif
+            if (worker.pid = fork(); worker.pid == 0) {
+#if defined(ACMACS_USE_PY)
+                PyOS_AfterFork_Child();
+#endif
+                ::dup2(::fileno(worker.out), STDOUT_FILENO);
+                ::dup2(::fileno(worker.err), STDERR_FILENO);
+                const auto file_exit_code = process(files[next_to_start], opt, backend, threads_per_worker);
+                std::fflush(stdout);
+                std::fflush(stderr);
+                std::_Exit(file_exit_code); // interpreter and static objects belong to the parent
+            }
+#if defined(ACMACS_USE_PY)
+            PyOS_AfterFork_Parent();
+#endif
+            if (worker.pid < 0)
+                throw std::runtime_error{fmt::format("fork failed: {}", std::strerror(errno))};
+        }
+
+        int status{0};
+        if (const auto pid = waitpid(-1, &status, 0); pid > 0) {
+            if (auto found = std::find_if(std::begin(workers), std::end(workers), [pid](const auto& worker) { return worker.pid == pid && !worker.finished; }); found != std::end(workers)) {
+                found->finished = true;
+                if (WIFEXITED(status))
+                    found->exit_code = WEXITSTATUS(status);
+                else {
+                    found->signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+                    found->exit_code = 3;
+                }
+                --running;
+            }
+        }
+        else
+            throw std::runtime_error{fmt::format("waitpid failed: {}", std::strerror(errno))};
+
+        for (; next_to_report < next_to_start && workers[next_to_report].finished; ++next_to_report) {
+            auto& worker = workers[next_to_report];
+            std::fflush(stdout);
+            copy_and_close(worker.err, stderr);
+            copy_and_close(worker.out, stdout);
+            std::fflush(stdout);
+            if (worker.signal != 0)
+                AD_ERROR("{}: worker terminated by signal {}", files[next_to_report], worker.signal);
+            if (worker.exit_code != 0)
+                exit_code = worker.exit_code;
+        }
+    }
+    return exit_code;
+
+} // process_in_parallel
+
+// ----------------------------------------------------------------------
+
+void copy_and_close(std::FILE* from, std::FILE* to)
+{
+    std::rewind(from);
+    std::array<char, 65536> buffer;
+    for (size_t read = std::fread(buffer.data(), 1, buffer.size(), from); read > 0; read = std::fread(buffer.data(), 1, buffer.size(), from))
+        std::fwrite(buffer.data(), 1, read, to);
+    std::fclose(from);
+
+} // copy_and_close
+
+// ----------------------------------------------------------------------
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "acmacs-base/argv.hh"
+#include "acmacs-base/range-v3.hh"
+#include "acmacs-whocc/xlsx.hh"
+#include "acmacs-whocc/log.hh"
+
+// ----------------------------------------------------------------------
+
+using namespace acmacs::argv;
+struct Options : public argv
+{
+    Options(int a_argc, const char* const a_argv[], on_error on_err = on_error::exit) : argv() { parse(a_argc, a_argv, on_err); }
+
+    option<str_array> backends{*this, 'b', "backend", desc{"backends to compare (multiple switches allowed), default: stream xlnt openxlsx"}};
+
+    argument<str_array> xlsx{*this, arg_name{".xlsx"}, mandatory};
+};
+
+static void measure(std::string_view filename, acmacs::xlsx::backend backend, std::string_view backend_name);
+
+int main(int argc, char* const argv[])
+{
+    using namespace std::string_view_literals;
+
+    int exit_code = 0;
+    try {
+        Options opt(argc, argv);
+        ::unsetenv("ACMACS_XLSX_SNAPSHOT_DIR"); // backends are measured, not loading of sheet snapshots
+        std::vector<std::string_view> backends{"stream"sv, "xlnt"sv, "openxlsx"sv};
+        if (const auto& requested = *opt.backends; !requested.empty())
+            backends = requested;
+
+        fmt::print("{:<10s} {:>10s} {:>10s} {:>8s} {:>10s} {:>14s} {:>12s}  {}\n", "backend", "open ms", "read ms", "sheets", "cells", "cells/sec", "peak RSS Mb", "file");
+        for (const auto& filename : *opt.xlsx) {
+            for (const auto& backend_name : backends) {
+                const auto backend = acmacs::xlsx::backend_from_name(backend_name);
+                // each measurement in a separate process, otherwise peak RSS of the previous backend is reported
+                std::fflush(stdout);
+                if (const auto pid = fork(); pid == 0) {
+                    int child_exit_code{0};
+                    try {
+                        measure(filename, backend, backend_name);
+                    }
+                    catch (std::exception& err) {
+                        AD_ERROR("{} {}: {}", backend_name, filename, err);
+                        child_exit_code = 3;
+                    }
+                    std::fflush(stdout);
+                    std::fflush(stderr);
+                    std::_Exit(child_exit_code); // atexit handlers and static objects belong to the parent
+                }
+                else if (pid > 0) {
+                    int status{0};
+                    waitpid(pid, &status, 0);
+                    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                        exit_code = 3;
+                }
+                else
+                    throw std::runtime_error{fmt::format("fork failed: {}", std::strerror(errno))};
+            }
+        }
+    }
+    catch (std::exception& err) {
+        AD_ERROR("{}", err);
+        exit_code = 2;
+    }
+    return exit_code;
+}
+
+// ----------------------------------------------------------------------
+
+void measure(std::string_view filename, acmacs::xlsx::backend backend, std::string_view backend_name)
+{
+    using clock = std::chrono::steady_clock;
+    const auto ms = [](clock::duration duration) { return std::chrono::duration<double, std::milli>{duration}.count(); };
+
+    const auto start = clock::now();
+    auto doc = acmacs::xlsx::open(filename, backend);
+    const auto opened = clock::now();
+
+    size_t cells{0}, non_empty{0};
+    for (const auto sheet_no : range_from_0_to(doc.number_of_sheets())) {
+        auto sheet = doc.sheet(sheet_no);
+        for (acmacs::sheet::nrow_t row{0}; row < sheet->number_of_rows(); ++row) {
+            for (acmacs::sheet::ncol_t col{0}; col < sheet->number_of_columns(); ++col) {
+                if (!acmacs::sheet::is_empty(sheet->cell_view(row, col)))
+                    ++non_empty;
+                ++cells;
+            }
+        }
+    }
+    const auto finished = clock::now();
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const auto read_seconds = std::chrono::duration<double>{finished - opened}.count();
+    fmt::print("{:<10s} {:>10.1f} {:>10.1f} {:>8d} {:>10d} {:>14.0f} {:>12.1f}  {} ({} non-empty)\n", backend_name, ms(opened - start), ms(finished - opened), doc.number_of_sheets(), cells,
+               read_seconds > 0 ? static_cast<double>(cells) / read_seconds : 0.0, static_cast<double>(usage.ru_maxrss) / 1024.0, filename, non_empty);
+    std::fflush(stdout);
+}
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
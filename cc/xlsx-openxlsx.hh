@@ -1,37 +1,79 @@
 #pragma once
 
+#include "acmacs-base/float.hh"
 #include "acmacs-base/openxlsx.hh"
+#include "acmacs-whocc/sheet-grid.hh"
+#include "acmacs-whocc/xlsx-stream.hh"
 
 // ----------------------------------------------------------------------
 
 namespace acmacs::xlsx::inline v1
 {
+    using acmacs::sheet::materialize;
+
     namespace openxlsx
     {
         class Doc;
 
-        class Sheet
+        class Sheet : public acmacs::sheet::Sheet
         {
           public:
-            std::string name() const { return sheet_.name(); }
+            std::string name() const override { return sheet_.name(); }
+            sheet::nrow_t number_of_rows() const override { return number_of_rows_; }
+            sheet::ncol_t number_of_columns() const override { return number_of_columns_; }
 
-            nrow_t number_of_rows() const
+            acmacs::sheet::cell_t cell(sheet::nrow_t row, sheet::ncol_t col) const override // row and col are zero based
             {
-                nrow_t cells{0};
-                fmt::print("lastCell {}\n", sheet_.lastCell().address());
-                for (auto& cell : sheet_.range(OpenXLSX::XLCellReference{1, 1},  sheet_.lastCell())) {
-                    fmt::print("cell {}:{}:{}\n", cell.cellReference().address(), cell.cellReference().row(), cell.cellReference().column());
-                    ++cells;
-                }
-                return cells;
+                return make_cell(sheet_.cell(static_cast<uint32_t>(*row + 1), static_cast<uint16_t>(*col + 1)));
             }
 
-            ncol_t number_of_columns() const { return static_cast<size_t>(sheet_.range().numColumns()); }
-
           private:
             mutable OpenXLSX::XLWorksheet sheet_;
+            const std::vector<bool>& date_styles_;
+            sheet::nrow_t number_of_rows_{0};
+            sheet::ncol_t number_of_columns_{0};
 
-            Sheet(OpenXLSX::XLWorksheet&& src) : sheet_{std::move(src)} {}
+            Sheet(OpenXLSX::XLWorksheet&& src, const std::vector<bool>& date_styles) : sheet_{std::move(src)}, date_styles_{date_styles}
+            {
+                // used range in one pass over the stored cells, trailing empty rows and columns are not included
+                for (auto& row : sheet_.rows()) {
+                    for (auto& cl : row.cells()) {
+                        if (!acmacs::sheet::is_empty(make_cell(cl))) {
+                            number_of_rows_ = std::max(number_of_rows_, sheet::nrow_t{cl.cellReference().row()});
+                            number_of_columns_ = std::max(number_of_columns_, sheet::ncol_t{cl.cellReference().column()});
+                        }
+                    }
+                }
+            }
+
+            acmacs::sheet::cell_t make_cell(const OpenXLSX::XLCell& cl) const
+            {
+                const auto value = cl.value();
+                switch (value.type()) {
+                    case OpenXLSX::XLValueType::Empty:
+                        return acmacs::sheet::cell::empty{};
+                    case OpenXLSX::XLValueType::Boolean:
+                        return value.get<bool>();
+                    case OpenXLSX::XLValueType::String:
+                        if (auto val = value.get<std::string>(); !val.empty())
+                            return val;
+                        else
+                            return acmacs::sheet::cell::empty{};
+                    case OpenXLSX::XLValueType::Integer:
+                    case OpenXLSX::XLValueType::Float:
+                        if (const auto style = cl.cellFormat(); style < date_styles_.size() && date_styles_[style])
+                            return stream::date_from_serial(value.get<double>(), false);
+                        else if (value.type() == OpenXLSX::XLValueType::Integer)
+                            return static_cast<long>(value.get<int64_t>());
+                        else if (const auto vald = value.get<double>(); !float_equal(vald, std::round(vald)))
+                            return vald;
+                        else
+                            return static_cast<long>(std::llround(vald));
+                    case OpenXLSX::XLValueType::Error:
+                        return acmacs::sheet::cell::error{};
+                }
+                return acmacs::sheet::cell::empty{};
+            }
 
             friend class Doc;
         };
@@ -39,16 +81,49 @@ namespace acmacs::xlsx::inline v1
         class Doc
         {
           public:
+            static constexpr uint32_t reader_version{1}; // bump when cells produced by the reader change, it is part of the snapshot key
+
+            Doc(std::string_view filename, materialize mat = materialize::yes) : doc_{std::string{filename}}, workbook_{doc_.workbook()}, sheet_names_{workbook_.worksheetNames()}, materialize_{mat}, sheet_info_{stream::read_sheet_info(filename)}
+            {
+                // date-ness of numeric cells is resolved once per cell style
+                const auto& cell_formats = doc_.styles().cellFormats();
+                const auto& number_formats = doc_.styles().numberFormats();
+                for (size_t style = 0; style < cell_formats.count(); ++style) {
+                    const auto num_fmt_id = cell_formats[style].numberFormatId();
+                    if (stream::is_builtin_date_format(num_fmt_id)) {
+                        date_styles_.push_back(true);
+                    }
+                    else {
+                        bool custom_date{false};
+                        for (size_t fmt_no = 0; fmt_no < number_formats.count(); ++fmt_no) {
+                            if (number_formats[fmt_no].numberFormatId() == num_fmt_id) {
+                                custom_date = stream::is_date_format_code(number_formats[fmt_no].formatCode());
+                                break;
+                            }
+                        }
+                        date_styles_.push_back(custom_date);
+                    }
+                }
+            }
+
             size_t number_of_sheets() const { return sheet_names_.size(); }
-            Sheet sheet(size_t sheet_no) { return workbook_.worksheet(sheet_names_[sheet_no]); }
+            acmacs::sheet::sheet_info_t sheet_info(size_t sheet_no) const { return stream::find_sheet_info(sheet_info_, sheet_names_.at(sheet_no)); }
 
-          protected:
-            Doc(std::string_view filename) : doc_{std::string{filename}}, workbook_{doc_.workbook()}, sheet_names_{workbook_.worksheetNames()} {}
+            std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no)
+            {
+                if (materialize_ == materialize::yes)
+                    return acmacs::sheet::GridSheet::materialize(Sheet{workbook_.worksheet(sheet_names_[sheet_no]), date_styles_});
+                else
+                    return std::shared_ptr<Sheet>{new Sheet{workbook_.worksheet(sheet_names_[sheet_no]), date_styles_}};
+            }
 
           private:
             OpenXLSX::XLDocument doc_;
             OpenXLSX::XLWorkbook workbook_;
             const std::vector<std::string> sheet_names_;
+            const materialize materialize_;
+            const std::vector<acmacs::sheet::sheet_info_t> sheet_info_; // OpenXLSX reports dimension of a worksheet only after loading it, it is read from <dimension> of sheet parts
+            std::vector<bool> date_styles_; // indexed by cell style id
         };
 
     } // namespace openxlsx
@@ -1,7 +1,11 @@
+#include <chrono>
+
 #include "acmacs-base/argv.hh"
 #include "acmacs-base/read-file.hh"
 #include "acmacs-base/range-v3.hh"
 #include "acmacs-whocc/xlsx.hh"
+#include "acmacs-whocc/titer-lexer.hh"
+#include "acmacs-whocc/anchor-lexer.hh"
 #include "acmacs-whocc/log.hh"
 
 // ----------------------------------------------------------------------
@@ -12,10 +16,18 @@ struct Options : public argv
     Options(int a_argc, const char* const a_argv[], on_error on_err = on_error::exit) : argv() { parse(a_argc, a_argv, on_err); }
 
     option<str_array> verbose{*this, 'v', "verbose", desc{"comma separated list (or multiple switches) of enablers"}};
+    option<bool> check_titer{*this, "check-titer", desc{"compare titer lexer with the reference regex on generated strings and on all string cells, report timing"}};
+    option<bool> check_anchors{*this, "check-anchors", desc{"compare extractor anchor matchers with the reference regexes on all string cells, report timing"}};
 
     argument<str_array> xlsx{*this, arg_name{".xlsx"}, mandatory};
 };
 
+static size_t check_titer_generated();
+static void check_titer(const std::vector<std::string>& cells);
+static size_t check_anchors(const std::vector<std::string>& cells);
+
+// ----------------------------------------------------------------------
+
 int main(int argc, char* const argv[])
 {
     using namespace std::string_view_literals;
@@ -26,21 +38,33 @@ int main(int argc, char* const argv[])
         Options opt(argc, argv);
         acmacs::log::enable(opt.verbose);
 
+        if (opt.check_titer && check_titer_generated() > 0)
+            exit_code = 1;
+
+        std::vector<std::string> string_cells;
         for (const auto& filename : *opt.xlsx) {
             AD_INFO("{}", filename);
             auto doc = acmacs::xlsx::open(filename);
+            doc.read_sheets();
             // AD_INFO("{} sheets: {}", filename, doc.number_of_sheets());
             for (const auto sheet_no : range_from_0_to(doc.number_of_sheets())) {
                 auto sheet = doc.sheet(sheet_no);
                 AD_INFO("    {}: \"{}\" {}-{}", sheet_no + 1, sheet->name(), sheet->number_of_rows(), sheet->number_of_columns());
                 for (acmacs::sheet::nrow_t row{0}; row < sheet->number_of_rows(); ++row) {
+                    const auto cells = sheet->row(row);
                     for (acmacs::sheet::ncol_t col{0}; col < sheet->number_of_columns(); ++col) {
-                        const auto cell = fmt::format("{}", sheet->cell(row, col));
+                        const auto cell = fmt::format("{}", cells[col]);
                         AD_LOG(acmacs::log::xlsx, "cell {}{}: \"{}\"", row, col, cell);
+                        if ((opt.check_titer || opt.check_anchors) && acmacs::sheet::is_string(cells[col]))
+                            string_cells.push_back(cell);
                     }
                 }
             }
         }
+        if (opt.check_titer)
+            check_titer(string_cells);
+        if (opt.check_anchors && check_anchors(string_cells) > 0)
+            exit_code = 1;
     }
     catch (std::exception& err) {
         AD_ERROR("{}", err);
@@ -49,6 +73,164 @@ int main(int argc, char* const argv[])
     return exit_code;
 }
 
+// ----------------------------------------------------------------------
+
+#include "acmacs-base/global-constructors-push.hh"
+
+// reference for acmacs::sheet::is_titer(), formerly used by Sheet::maybe_titer
+static const std::regex re_titer{R"(^\s*(<|>|,|(?:<|>|\xEF\xBC\x9C)?\s*[1-9][0-9]{0,5}|N[DAT]|QNS|\*)\s*$)", acmacs::regex::icase};
+
+// references for the matchers in anchor-lexer.hh, formerly used by the extractors
+struct anchor_reference_t
+{
+    const char* name;
+    std::regex re;
+    acmacs::sheet::text_matcher_t matcher;
+};
+
+static const std::vector<anchor_reference_t> anchor_references{
+    {"serum_passage", std::regex{"^(MDCK|QMC|C|SIAT|S|E|HCK|CELL|EGG)", acmacs::regex::icase}, acmacs::sheet::anchor::serum_passage},
+    {"CDC_antigen_lab_id", std::regex{"^[0-9]{10}$", acmacs::regex::icase}, acmacs::sheet::anchor::CDC_antigen_lab_id},
+    {"CDC_serum_index", std::regex{"^([A-Z]|EGG)$", acmacs::regex::icase}, acmacs::sheet::anchor::CDC_serum_index},
+    {"CDC_titer_label", std::regex{R"(^\s*(BACK)?\s*TITER\b)", acmacs::regex::icase}, acmacs::sheet::anchor::CDC_titer_label},
+    {"CDC_ha_group_label", std::regex{R"(^\s*HA\s*GROUP\b)", acmacs::regex::icase}, acmacs::sheet::anchor::CDC_ha_group_label},
+    {"CDC_antigen_control", std::regex{R"(\bCONTROL\b)", acmacs::regex::icase}, acmacs::sheet::anchor::CDC_antigen_control},
+    {"AC21_serum_index", std::regex{R"(^[0-9]+$)", acmacs::regex::icase}, acmacs::sheet::anchor::AC21_serum_index},
+    {"CRICK_serum_name_1", std::regex{"^([AB]/[A-Z '_-]+|NYMC\\s+X-[0-9]+[A-Z]*)$", acmacs::regex::icase}, acmacs::sheet::anchor::CRICK_serum_name_1},
+    {"CRICK_serum_name_2", std::regex{"^[A-Z0-9-/]+$", acmacs::regex::icase}, acmacs::sheet::anchor::CRICK_serum_name_2},
+    {"CRICK_serum_id", std::regex{R"(^(?:[A-Z\s]+\s+)?\s*(F[0-9]+/[0-2][0-9]|SH[\s\d,/]+)(?:\*(\d)(?:,\d)?)?$)", acmacs::regex::icase}, acmacs::sheet::anchor::CRICK_serum_id},
+    {"CRICK_prn_2fold", std::regex{"^2-fold$", acmacs::regex::icase}, acmacs::sheet::anchor::CRICK_prn_2fold},
+    {"CRICK_prn_read", std::regex{"^read$", acmacs::regex::icase}, acmacs::sheet::anchor::CRICK_prn_read},
+    {"NIID_serum_name", std::regex{R"(^\s*(?:\d+[A-Z]\s+)?([A-Z][A-Z\d\s\-_\./\(\)]+)\s+NO\s*\.\s*([\d\-]+)$)", acmacs::regex::icase}, acmacs::sheet::anchor::NIID_serum_name},
+    {"NIID_serum_name_row_non_serum_label", std::regex{R"((HA\s*group))", acmacs::regex::icase}, acmacs::sheet::anchor::NIID_serum_name_row_non_serum_label},
+    {"VIDRL_antigen_lab_id", std::regex{"^(SL|VW)[0-9]{8}$", acmacs::regex::icase}, acmacs::sheet::anchor::VIDRL_antigen_lab_id},
+    {"VIDRL_antigen_date_column_title", std::regex{"^\\s*Sample\\s*Date\\s*$", acmacs::regex::icase}, acmacs::sheet::anchor::VIDRL_antigen_date_column_title},
+    {"VIDRL_antigen_lab_id_column_title", std::regex{"^\\s*VW\\s*$", acmacs::regex::icase}, acmacs::sheet::anchor::VIDRL_antigen_lab_id_column_title},
+    {"VIDRL_serum_name", std::regex{"^(?:[AB]/)?([A-Z][A-Z ]+)/?([0-9]+)(?:_.*)?$", acmacs::regex::icase}, acmacs::sheet::anchor::VIDRL_serum_name},
+    {"VIDRL_serum_id", std::regex{"^([AF][0-9][0-9][0-9][0-9](?:-[0-9]+D)?|F[0-9]+/[0-2][0-9])$", acmacs::regex::icase}, acmacs::sheet::anchor::VIDRL_serum_id},
+    {"VIDRL_serum_id_with_days", std::regex{"^[AF][0-9][0-9][0-9][0-9]-[0-9]+D$", acmacs::regex::icase}, acmacs::sheet::anchor::VIDRL_serum_id_with_days},
+    {"human_who_serum", std::regex{R"(^\s*(.*(HUMAN|WHO|NORMAL)|GOAT|POST? VAX)\b)", acmacs::regex::icase}, acmacs::sheet::anchor::human_who_serum},
+};
+
+#include "acmacs-base/diagnostics-pop.hh"
+
+// all strings up to 5 symbols made of the symbols significant for re_titer
+// and numbers of up to 8 digits with prefixes and spaces
+size_t check_titer_generated()
+{
+    const std::vector<std::string_view> alphabet{" ", "\t", "<", ">", ",", "*", "0", "1", "9", "n", "N", "D", "a", "T", "q", "S", "x", "\xEF\xBC\x9C", "\xEF"};
+    constexpr const size_t max_length{5};
+
+    size_t checked{0}, mismatches{0};
+    const auto check = [&checked, &mismatches](const std::string& src) {
+        if (std::regex_search(src, re_titer) != acmacs::sheet::is_titer(src)) {
+            if (mismatches < 20)
+                AD_ERROR("titer lexer mismatch: \"{}\" regex:{}", src, std::regex_search(src, re_titer));
+            ++mismatches;
+        }
+        ++checked;
+    };
+
+    for (const auto* prefix : {"", " ", "<", ">", "\xEF\xBC\x9C", " < ", "<\t", ">  "}) {
+        for (const auto* suffix : {"", " ", "\n"}) {
+            for (std::string digits{"1"}; digits.size() < 9; digits.push_back('0')) {
+                check(fmt::format("{}{}{}", prefix, digits, suffix));
+                check(fmt::format("{}{}{}", prefix, std::string(digits.size(), '9'), suffix));
+            }
+        }
+    }
+
+    std::vector<size_t> symbols;
+    std::string src;
+    while (symbols.size() <= max_length) {
+        src.clear();
+        for (const auto sym : symbols)
+            src.append(alphabet[sym]);
+        check(src);
+        // next combination
+        auto pos = symbols.begin();
+        for (; pos != symbols.end() && *pos == (alphabet.size() - 1); ++pos)
+            *pos = 0;
+        if (pos == symbols.end())
+            symbols.push_back(0);
+        else
+            ++*pos;
+    }
+    AD_INFO("titer lexer vs regex: {} generated strings checked, {} mismatches", checked, mismatches);
+    return mismatches;
+
+} // check_titer_generated
+
+// ----------------------------------------------------------------------
+
+void check_titer(const std::vector<std::string>& cells)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr const size_t repeat{100};
+
+    size_t mismatches{0}, regex_titers{0}, lexer_titers{0};
+    for (const auto& cell : cells) {
+        if (std::regex_search(cell, re_titer) != acmacs::sheet::is_titer(cell)) {
+            AD_ERROR("titer lexer mismatch: \"{}\"", cell);
+            ++mismatches;
+        }
+    }
+
+    const auto regex_start = clock::now();
+    for (size_t rep = 0; rep < repeat; ++rep)
+        regex_titers += static_cast<size_t>(ranges::count_if(cells, [](const auto& cell) { return std::regex_search(cell, re_titer); }));
+    const auto lexer_start = clock::now();
+    for (size_t rep = 0; rep < repeat; ++rep)
+        lexer_titers += static_cast<size_t>(ranges::count_if(cells, [](const auto& cell) { return acmacs::sheet::is_titer(cell); }));
+    const auto lexer_end = clock::now();
+
+    const std::chrono::duration<double, std::micro> regex_time{lexer_start - regex_start}, lexer_time{lexer_end - lexer_start};
+    AD_INFO("titer lexer vs regex: {} string cells, {} titers, {} mismatches\n    regex: {:.1f}us lexer: {:.1f}us speedup: {:.1f}x ({} repetitions)", cells.size(), lexer_titers / repeat, mismatches,
+            regex_time.count(), lexer_time.count(), lexer_time.count() > 0 ? regex_time.count() / lexer_time.count() : 0.0, repeat);
+    if (regex_titers != lexer_titers)
+        AD_ERROR("titer lexer vs regex: different number of titers: regex:{} lexer:{}", regex_titers / repeat, lexer_titers / repeat);
+
+} // check_titer
+
+// ----------------------------------------------------------------------
+
+size_t check_anchors(const std::vector<std::string>& cells)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::chrono::duration<double, std::micro> regex_time{0}, matcher_time{0};
+    size_t total_mismatches{0};
+    for (const auto& ref : anchor_references) {
+        size_t mismatches{0}, matches{0};
+        for (const auto& cell : cells) {
+            if (const auto matched = ref.matcher(cell); std::regex_search(cell, ref.re) != matched) {
+                if (mismatches < 20)
+                    AD_ERROR("anchor {} mismatch: \"{}\" matcher:{}", ref.name, cell, matched);
+                ++mismatches;
+            }
+            else if (matched)
+                ++matches;
+        }
+        if (mismatches > 0 || matches > 0)
+            AD_INFO("anchor {}: {} matches, {} mismatches", ref.name, matches, mismatches);
+        total_mismatches += mismatches;
+
+        const auto regex_start = clock::now();
+        const auto regex_matches = ranges::count_if(cells, [&ref](const auto& cell) { return std::regex_search(cell, ref.re); });
+        const auto matcher_start = clock::now();
+        const auto matcher_matches = ranges::count_if(cells, [&ref](const auto& cell) { return ref.matcher(cell); });
+        const auto matcher_end = clock::now();
+        regex_time += matcher_start - regex_start;
+        matcher_time += matcher_end - matcher_start;
+        if (regex_matches != matcher_matches)
+            AD_ERROR("anchor {}: different number of matches: regex:{} matcher:{}", ref.name, regex_matches, matcher_matches);
+    }
+    AD_INFO("anchor matchers vs regexes: {} string cells, {} patterns, {} mismatches\n    regex: {:.1f}us matcher: {:.1f}us speedup: {:.1f}x", cells.size(), anchor_references.size(), total_mismatches,
+            regex_time.count(), matcher_time.count(), matcher_time.count() > 0 ? regex_time.count() / matcher_time.count() : 0.0);
+    return total_mismatches;
+
+} // check_anchors
+
 // ----------------------------------------------------------------------
 /// Local Variables:
 /// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
@@ -0,0 +1,230 @@
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <unistd.h>
+
+#include "acmacs-whocc/log.hh"
+#include "acmacs-whocc/xlsx-snapshot.hh"
+
+// ----------------------------------------------------------------------
+
+namespace
+{
+    // bump when grid_cell_t layout or snapshot format changes, changes of cells produced by a backend are tracked by its reader_version
+    constexpr const uint32_t snapshot_version{2};
+    constexpr const std::string_view snapshot_magic{"ACXLSNAP"};
+    constexpr const uint32_t byte_order_mark{0x01020304};
+
+    struct file_header_t
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t number_of_sheets;
+    };
+
+    // cells and arena follow the name only if the sheet has_cells (it was read), the grid is number_of_rows x number_of_columns
+    // dimension (if has_dimension) is the one recorded in the workbook, it is used by sheet_info()
+    struct sheet_header_t
+    {
+        uint32_t name_size;
+        uint32_t number_of_rows;
+        uint32_t number_of_columns;
+        uint32_t flags;
+        uint64_t arena_size;
+        uint32_t dimension_rows;
+        uint32_t dimension_columns;
+    };
+
+    enum sheet_flags : uint32_t { has_cells = 1 << 0, has_dimension = 1 << 1 };
+
+    static_assert(sizeof(file_header_t) == 24 && sizeof(sheet_header_t) == 32);
+
+    constexpr size_t aligned(size_t size) { return (size + 7) & ~size_t{7}; }
+
+    inline void append(std::string& target, const void* data, size_t size)
+    {
+        target.append(static_cast<const char*>(data), size);
+        target.append(aligned(size) - size, '\0');
+    }
+
+    // bounds checked reading of the snapshot content
+    class reader_t
+    {
+      public:
+        reader_t(std::string_view source) : source_{source} {}
+
+        template <typename T> T get()
+        {
+            T result;
+            std::memcpy(&result, take(sizeof(T)).data(), sizeof(T));
+            return result;
+        }
+
+        std::string_view take(size_t size)
+        {
+            if (aligned(size) > source_.size() - pos_)
+                throw std::runtime_error{"truncated snapshot"};
+            const auto result = source_.substr(pos_, size);
+            pos_ += aligned(size);
+            return result;
+        }
+
+      private:
+        std::string_view source_;
+        size_t pos_{0};
+    };
+
+    inline std::string read_file(std::string_view filename)
+    {
+        std::ifstream input{std::string{filename}, std::ios::binary};
+        if (!input)
+            return {};
+        return std::string{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+    }
+
+    struct content_hash_t
+    {
+        uint64_t hash{0xcbf29ce484222325};
+        size_t size{0};
+    };
+
+    // FNV-1a of the file read in blocks, workbook is not kept in memory
+    inline content_hash_t content_hash(std::string_view filename)
+    {
+        content_hash_t result;
+        std::ifstream input{std::string{filename}, std::ios::binary};
+        std::array<char, 65536> block;
+        while (input) {
+            input.read(block.data(), block.size());
+            const auto size = static_cast<size_t>(input.gcount());
+            for (const char cc : std::string_view{block.data(), size}) {
+                result.hash ^= static_cast<uint8_t>(cc);
+                result.hash *= 0x100000001b3;
+            }
+            result.size += size;
+        }
+        return result;
+    }
+
+} // namespace
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::xlsx::v1::snapshot::directory_from_environment()
+{
+    if (const char* env = std::getenv("ACMACS_XLSX_SNAPSHOT_DIR"); env)
+        return env;
+    return {};
+
+} // acmacs::xlsx::v1::snapshot::directory_from_environment
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::xlsx::v1::snapshot::filename(std::string_view directory, std::string_view workbook_filename, std::string_view backend_name, uint32_t reader_version)
+{
+    const auto content = content_hash(workbook_filename);
+    return fmt::format("{}/{:016x}-{}-{}.r{}-v{}.sheets", directory, content.hash, content.size, backend_name, reader_version, snapshot_version);
+
+} // acmacs::xlsx::v1::snapshot::filename
+
+// ----------------------------------------------------------------------
+
+void acmacs::xlsx::v1::snapshot::write(std::string_view filename, const std::vector<std::shared_ptr<acmacs::sheet::Sheet>>& sheets, const std::vector<acmacs::sheet::sheet_info_t>& info)
+{
+    file_header_t file_header{.magic = {}, .version = snapshot_version, .byte_order = byte_order_mark, .number_of_sheets = sheets.size()};
+    std::memcpy(file_header.magic, snapshot_magic.data(), sizeof(file_header.magic));
+    std::string data;
+    append(data, &file_header, sizeof(file_header));
+    for (size_t sheet_no = 0; sheet_no < sheets.size(); ++sheet_no) {
+        const auto& sheet_info = info.at(sheet_no);
+        sheet_header_t sheet_header{.name_size = static_cast<uint32_t>(sheet_info.name.size()),
+                                    .number_of_rows = 0,
+                                    .number_of_columns = 0,
+                                    .flags = 0,
+                                    .arena_size = 0,
+                                    .dimension_rows = sheet_info.dimension ? static_cast<uint32_t>(*sheet_info.dimension->row) : 0u,
+                                    .dimension_columns = sheet_info.dimension ? static_cast<uint32_t>(*sheet_info.dimension->col) : 0u};
+        if (sheet_info.dimension)
+            sheet_header.flags |= has_dimension;
+        if (const auto& sheet = sheets[sheet_no]; sheet) {
+            const auto& grid = sheet->grid();
+            sheet_header.number_of_rows = static_cast<uint32_t>(*grid.number_of_rows());
+            sheet_header.number_of_columns = static_cast<uint32_t>(*grid.number_of_columns());
+            sheet_header.flags |= has_cells;
+            sheet_header.arena_size = grid.arena().size();
+            append(data, &sheet_header, sizeof(sheet_header));
+            append(data, sheet_info.name.data(), sheet_info.name.size());
+            append(data, grid.cells().data(), grid.cells().size() * sizeof(acmacs::sheet::grid_cell_t));
+            append(data, grid.arena().data(), grid.arena().size());
+        }
+        else {
+            append(data, &sheet_header, sizeof(sheet_header));
+            append(data, sheet_info.name.data(), sheet_info.name.size());
+        }
+    }
+
+    std::error_code ec;
+    const std::filesystem::path target{filename};
+    std::filesystem::create_directories(target.parent_path(), ec);
+    auto temp = target;
+    temp += fmt::format(".{}.tmp", getpid());
+    if (std::ofstream output{temp, std::ios::binary | std::ios::trunc}; !output || !output.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+        AD_WARNING("cannot write sheet snapshot {}", temp.native());
+        std::filesystem::remove(temp, ec);
+        return;
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec)
+        AD_WARNING("cannot write sheet snapshot {}: {}", filename, ec.message());
+
+} // acmacs::xlsx::v1::snapshot::write
+
+// ----------------------------------------------------------------------
+
+std::unique_ptr<acmacs::xlsx::v1::snapshot::Doc> acmacs::xlsx::v1::snapshot::Doc::load(std::string_view filename)
+{
+    using namespace acmacs::sheet;
+
+    const auto content = read_file(filename);
+    if (content.empty())
+        return nullptr;
+    try {
+        reader_t reader{content};
+        const auto file_header = reader.get<file_header_t>();
+        if (std::string_view{file_header.magic, sizeof(file_header.magic)} != snapshot_magic || file_header.version != snapshot_version || file_header.byte_order != byte_order_mark)
+            throw std::runtime_error{"unsupported snapshot"};
+        auto doc = std::make_unique<Doc>();
+        for (uint64_t sheet_no = 0; sheet_no < file_header.number_of_sheets; ++sheet_no) {
+            const auto sheet_header = reader.get<sheet_header_t>();
+            const auto name = reader.take(sheet_header.name_size);
+            auto& sheet_info = doc->info_.emplace_back(sheet_info_t{.name = std::string{name}});
+            if (sheet_header.flags & has_dimension)
+                sheet_info.dimension = cell_addr_t{nrow_t{sheet_header.dimension_rows}, ncol_t{sheet_header.dimension_columns}};
+            if (!(sheet_header.flags & has_cells)) {
+                doc->sheets_.push_back(nullptr);
+                continue;
+            }
+            const size_t number_of_cells = size_t{sheet_header.number_of_rows} * sheet_header.number_of_columns;
+            const auto raw_cells = reader.take(number_of_cells * sizeof(grid_cell_t));
+            std::vector<grid_cell_t> cells(number_of_cells);
+            std::memcpy(cells.data(), raw_cells.data(), raw_cells.size());
+            const auto arena = reader.take(sheet_header.arena_size);
+            doc->sheets_.push_back(std::make_shared<GridSheet>(name, cell_grid_t{nrow_t{sheet_header.number_of_rows}, ncol_t{sheet_header.number_of_columns}, std::move(cells), std::string{arena}}));
+        }
+        AD_INFO("sheet snapshot {}", filename);
+        return doc;
+    }
+    catch (std::exception& err) {
+        AD_WARNING("sheet snapshot {} ignored: {}", filename, err);
+        return nullptr;
+    }
+
+} // acmacs::xlsx::v1::snapshot::Doc::load
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
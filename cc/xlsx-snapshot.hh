@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+
+#include "acmacs-whocc/sheet-grid.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::xlsx::inline v1
+{
+    namespace snapshot
+    {
+        // Materialized sheets of a workbook in a binary file: fixed size
+        // header, then for each sheet its name, raw grid cells and string
+        // arena, all 8-byte aligned. Sheets that were not read (ignored
+        // ones) are kept as name and dimension only, the dimension
+        // recorded in the workbook is kept for all sheets, sheet_info()
+        // of the snapshot is the one of the backend. Snapshot is keyed by
+        // the workbook content hash, backend and its reader version, it is
+        // used only if ACMACS_XLSX_SNAPSHOT_DIR is set.
+
+        // snapshot directory, empty if snapshots are not used
+        std::string directory_from_environment();
+
+        // snapshot file for the current content of the workbook read by the backend
+        std::string filename(std::string_view directory, std::string_view workbook_filename, std::string_view backend_name, uint32_t reader_version);
+
+        // written via temporary file, concurrent runs do not see partial snapshots
+        // sheets that were not read are nullptr, name and dimension of all sheets are taken from info
+        void write(std::string_view filename, const std::vector<std::shared_ptr<acmacs::sheet::Sheet>>& sheets, const std::vector<acmacs::sheet::sheet_info_t>& info);
+
+        class Doc
+        {
+          public:
+            static std::unique_ptr<Doc> load(std::string_view filename); // nullptr if there is no valid snapshot
+
+            size_t number_of_sheets() const { return sheets_.size(); }
+            acmacs::sheet::sheet_info_t sheet_info(size_t sheet_no) const { return info_.at(sheet_no); }
+            bool has_sheet(size_t sheet_no) const { return sheets_.at(sheet_no) != nullptr; }
+            std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no) { return sheets_.at(sheet_no); } // nullptr if sheet was not read when snapshot was written
+
+          private:
+            std::vector<std::shared_ptr<acmacs::sheet::GridSheet>> sheets_;
+            std::vector<acmacs::sheet::sheet_info_t> info_;
+        };
+
+    } // namespace snapshot
+
+} // namespace acmacs::xlsx::inline v1
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,827 @@
+#include <fstream>
+#include <deque>
+#include <unordered_map>
+#include <charconv>
+#include <mutex>
+#include <cmath>
+#include <zlib.h>
+
+#include "acmacs-base/float.hh"
+#include "acmacs-whocc/log.hh"
+#include "acmacs-whocc/xlsx-stream.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::xlsx::inline v1::stream
+{
+    struct Error : public std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    // ----------------------------------------------------------------------
+
+    class zip_archive
+    {
+      public:
+        zip_archive(std::string_view filename) : filename_{filename}, file_{filename_, std::ios::binary}
+        {
+            if (!file_)
+                throw Error{fmt::format("cannot open {}", filename_)};
+            read_central_directory();
+        }
+
+        bool has(std::string_view name) const { return entries_.find(std::string{name}) != entries_.end(); }
+
+        // returns empty string if entry is not found, max_size limits the result, e.g. to look at the header of a large part
+        std::string read(std::string_view name, size_t max_size = std::numeric_limits<size_t>::max())
+        {
+            const auto found = entries_.find(std::string{name});
+            if (found == entries_.end())
+                return {};
+            const auto& entry = found->second;
+
+            const auto local_header = read_at(entry.local_header_offset, 30);
+            if (u32(local_header, 0) != 0x04034b50)
+                throw Error{fmt::format("{}: invalid local header for {}", filename_, name)};
+            const auto data_offset = entry.local_header_offset + 30 + u16(local_header, 26) + u16(local_header, 28);
+
+            switch (entry.method) {
+                case 0: // stored
+                    return read_at(data_offset, std::min(entry.compressed_size, max_size));
+                case 8: // deflate
+                    if (max_size < entry.uncompressed_size)
+                        return inflate(read_at(data_offset, std::min(entry.compressed_size, max_size + 1024)), max_size, name, inflate_mode::prefix); // deflate does not expand data beyond block headers
+                    return inflate(read_at(data_offset, entry.compressed_size), entry.uncompressed_size, name);
+                default:
+                    throw Error{fmt::format("{}: unsupported compression method {} for {}", filename_, entry.method, name)};
+            }
+        }
+
+      private:
+        struct entry_t
+        {
+            uint16_t method;
+            size_t compressed_size;
+            size_t uncompressed_size;
+            size_t local_header_offset;
+        };
+
+        const std::string filename_;
+        std::ifstream file_;
+        std::mutex file_access_; // entries of the archive may be read concurrently, inflating is not serialized
+        std::unordered_map<std::string, entry_t> entries_;
+
+        static uint16_t u16(std::string_view src, size_t offset) { return static_cast<uint16_t>(static_cast<uint8_t>(src[offset]) | (static_cast<uint8_t>(src[offset + 1]) << 8)); }
+        static uint32_t u32(std::string_view src, size_t offset) { return static_cast<uint32_t>(u16(src, offset)) | (static_cast<uint32_t>(u16(src, offset + 2)) << 16); }
+
+        std::string read_at(size_t offset, size_t size)
+        {
+            std::string result(size, '\0');
+            std::unique_lock lock{file_access_};
+            file_.seekg(static_cast<std::streamoff>(offset));
+            if (!file_.read(result.data(), static_cast<std::streamsize>(size)))
+                throw Error{fmt::format("{}: cannot read {} bytes at {}", filename_, size, offset)};
+            return result;
+        }
+
+        void read_central_directory()
+        {
+            file_.seekg(0, std::ios::end);
+            const auto file_size = static_cast<size_t>(file_.tellg());
+            constexpr const size_t eocd_size{22}, max_comment{0xFFFF};
+            if (file_size < eocd_size)
+                throw Error{fmt::format("{}: not a zip file", filename_)};
+            const auto tail_size = std::min(file_size, eocd_size + max_comment);
+            const auto tail = read_at(file_size - tail_size, tail_size);
+            size_t eocd = tail_size - eocd_size + 1;
+            do {
+                --eocd;
+                if (u32(tail, eocd) == 0x06054b50)
+                    break;
+            } while (eocd > 0);
+            if (u32(tail, eocd) != 0x06054b50)
+                throw Error{fmt::format("{}: zip end of central directory not found", filename_)};
+
+            const size_t number_of_entries = u16(tail, eocd + 10);
+            const size_t directory_size = u32(tail, eocd + 12), directory_offset = u32(tail, eocd + 16);
+            if (number_of_entries == 0xFFFF || directory_size == 0xFFFFFFFF || directory_offset == 0xFFFFFFFF)
+                throw Error{fmt::format("{}: zip64 is not supported", filename_)};
+
+            const auto directory = read_at(directory_offset, directory_size);
+            size_t pos{0};
+            for (size_t entry_no = 0; entry_no < number_of_entries; ++entry_no) {
+                if (pos + 46 > directory.size() || u32(directory, pos) != 0x02014b50)
+                    throw Error{fmt::format("{}: invalid zip central directory", filename_)};
+                const size_t name_size = u16(directory, pos + 28), extra_size = u16(directory, pos + 30), comment_size = u16(directory, pos + 32);
+                // real values of sizes and offset marked 0xFFFFFFFF are in the zip64 extra field
+                if (u32(directory, pos + 20) == 0xFFFFFFFF || u32(directory, pos + 24) == 0xFFFFFFFF || u32(directory, pos + 42) == 0xFFFFFFFF)
+                    throw Error{fmt::format("{}: zip64 is not supported", filename_)};
+                entries_.emplace(directory.substr(pos + 46, name_size), entry_t{.method = u16(directory, pos + 10),
+                                                                                 .compressed_size = u32(directory, pos + 20),
+                                                                                 .uncompressed_size = u32(directory, pos + 24),
+                                                                                 .local_header_offset = u32(directory, pos + 42)});
+                pos += 46 + name_size + extra_size + comment_size;
+            }
+        }
+
+        enum class inflate_mode { whole, prefix };
+
+        std::string inflate(const std::string& compressed, size_t uncompressed_size, std::string_view name, inflate_mode mode = inflate_mode::whole) const
+        {
+            std::string result(uncompressed_size, '\0');
+            z_stream strm{};
+            if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) // raw deflate, no zlib header
+                throw Error{fmt::format("{}: inflateInit2 failed", filename_)};
+            strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+            strm.avail_in = static_cast<uInt>(compressed.size());
+            strm.next_out = reinterpret_cast<Bytef*>(result.data());
+            strm.avail_out = static_cast<uInt>(result.size());
+            const auto status = ::inflate(&strm, mode == inflate_mode::whole ? Z_FINISH : Z_SYNC_FLUSH);
+            inflateEnd(&strm);
+            if (status != Z_STREAM_END && (mode == inflate_mode::whole || (status != Z_OK && status != Z_BUF_ERROR)))
+                throw Error{fmt::format("{}: cannot inflate {}: {}", filename_, name, status)};
+            result.resize(strm.total_out);
+            return result;
+        }
+    };
+
+    // ----------------------------------------------------------------------
+
+    // SAX-style scanner over xml text, no validation, element and
+    // attribute names are reported without namespace prefix
+    class xml_scanner
+    {
+      public:
+        enum class token { start, end, text, eof };
+
+        xml_scanner(std::string_view source) : source_{source} {}
+
+        token next()
+        {
+            attributes_ = std::string_view{};
+            self_closing_ = false;
+            if (pending_end_) {
+                pending_end_ = false;
+                return token::end;
+            }
+            if (pos_ >= source_.size())
+                return token::eof;
+
+            if (source_[pos_] != '<') {
+                const auto end = source_.find('<', pos_);
+                text_ = source_.substr(pos_, end - pos_);
+                pos_ = end == std::string_view::npos ? source_.size() : end;
+                return token::text;
+            }
+
+            if (source_.compare(pos_, 9, "<![CDATA[") == 0) {
+                const auto end = source_.find("]]>", pos_ + 9);
+                text_ = source_.substr(pos_ + 9, end - pos_ - 9);
+                pos_ = end == std::string_view::npos ? source_.size() : end + 3;
+                return token::text;
+            }
+            if (source_.compare(pos_, 4, "<!--") == 0) {
+                skip_past("-->");
+                return next();
+            }
+            if (source_.compare(pos_, 2, "<?") == 0 || source_.compare(pos_, 2, "<!") == 0) {
+                skip_past(">");
+                return next();
+            }
+
+            if (pos_ + 1 >= source_.size()) // truncated part ends with <
+                throw Error{"unterminated xml tag"};
+            const bool closing = source_[pos_ + 1] == '/';
+            const auto tag_end = find_tag_end(pos_);
+            auto tag = source_.substr(pos_ + (closing ? 2 : 1), tag_end - pos_ - (closing ? 2 : 1));
+            pos_ = tag_end + 1;
+            if (!tag.empty() && tag.back() == '/') {
+                self_closing_ = true;
+                tag.remove_suffix(1);
+            }
+            const auto name_end = tag.find_first_of(" \t\r\n");
+            name_ = local_name(tag.substr(0, name_end));
+            if (name_end != std::string_view::npos)
+                attributes_ = tag.substr(name_end);
+            if (closing)
+                return token::end;
+            pending_end_ = self_closing_;
+            return token::start;
+        }
+
+        std::string_view name() const { return name_; }
+        std::string_view text() const { return text_; }
+
+        // attribute of the current start element, raw (not unescaped)
+        std::string_view attribute(std::string_view name) const
+        {
+            size_t pos{0};
+            while (pos < attributes_.size()) {
+                pos = attributes_.find_first_not_of(" \t\r\n", pos);
+                if (pos == std::string_view::npos)
+                    break;
+                const auto eq = attributes_.find('=', pos);
+                if (eq == std::string_view::npos)
+                    break;
+                const auto attr_name = local_name(trim(attributes_.substr(pos, eq - pos)));
+                const auto quote_pos = attributes_.find_first_of("\"'", eq);
+                if (quote_pos == std::string_view::npos)
+                    break;
+                const auto value_end = attributes_.find(attributes_[quote_pos], quote_pos + 1);
+                if (value_end == std::string_view::npos)
+                    break;
+                if (attr_name == name)
+                    return attributes_.substr(quote_pos + 1, value_end - quote_pos - 1);
+                pos = value_end + 1;
+            }
+            return {};
+        }
+
+        static void unescape(std::string_view source, std::string& target)
+        {
+            for (size_t pos = 0; pos < source.size(); ++pos) {
+                if (source[pos] != '&') {
+                    target.push_back(source[pos]);
+                    continue;
+                }
+                const auto semicolon = source.find(';', pos);
+                if (semicolon == std::string_view::npos) {
+                    target.append(source.substr(pos));
+                    break;
+                }
+                const auto entity = source.substr(pos + 1, semicolon - pos - 1);
+                if (entity == "amp")
+                    target.push_back('&');
+                else if (entity == "lt")
+                    target.push_back('<');
+                else if (entity == "gt")
+                    target.push_back('>');
+                else if (entity == "quot")
+                    target.push_back('"');
+                else if (entity == "apos")
+                    target.push_back('\'');
+                else if (!entity.empty() && entity[0] == '#') {
+                    unsigned code{0};
+                    if (entity.size() > 1 && (entity[1] == 'x' || entity[1] == 'X'))
+                        std::from_chars(entity.data() + 2, entity.data() + entity.size(), code, 16);
+                    else
+                        std::from_chars(entity.data() + 1, entity.data() + entity.size(), code, 10);
+                    append_utf8(code, target);
+                }
+                else
+                    target.append(source.substr(pos, semicolon - pos + 1));
+                pos = semicolon;
+            }
+        }
+
+      private:
+        std::string_view source_;
+        size_t pos_{0};
+        std::string_view name_{};
+        std::string_view attributes_{};
+        std::string_view text_{};
+        bool self_closing_{false};
+        bool pending_end_{false};
+
+        void skip_past(std::string_view terminator)
+        {
+            const auto end = source_.find(terminator, pos_);
+            pos_ = end == std::string_view::npos ? source_.size() : end + terminator.size();
+        }
+
+        size_t find_tag_end(size_t pos) const
+        {
+            char quote{0};
+            for (; pos < source_.size(); ++pos) {
+                if (quote) {
+                    if (source_[pos] == quote)
+                        quote = 0;
+                }
+                else if (source_[pos] == '"' || source_[pos] == '\'')
+                    quote = source_[pos];
+                else if (source_[pos] == '>')
+                    return pos;
+            }
+            throw Error{"unterminated xml tag"};
+        }
+
+        static std::string_view local_name(std::string_view name)
+        {
+            if (const auto colon = name.find(':'); colon != std::string_view::npos)
+                return name.substr(colon + 1);
+            return name;
+        }
+
+        static std::string_view trim(std::string_view src)
+        {
+            while (!src.empty() && std::isspace(static_cast<unsigned char>(src.back())))
+                src.remove_suffix(1);
+            return src;
+        }
+
+        static void append_utf8(unsigned code, std::string& target)
+        {
+            if (code < 0x80) {
+                target.push_back(static_cast<char>(code));
+            }
+            else if (code < 0x800) {
+                target.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                target.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else if (code < 0x10000) {
+                target.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                target.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                target.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else {
+                target.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                target.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                target.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                target.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+        }
+    };
+
+    // ----------------------------------------------------------------------
+
+    // number format code denotes date/time if it has d, m, y, h or s outside of quoted text and [] sections
+    bool is_date_format_code(std::string_view code)
+    {
+        bool quoted{false}, bracket{false}, escaped{false};
+        for (const char sym : code) {
+            if (escaped)
+                escaped = false;
+            else if (quoted)
+                quoted = sym != '"';
+            else if (bracket)
+                bracket = sym != ']';
+            else {
+                switch (sym) {
+                    case '"':
+                        quoted = true;
+                        break;
+                    case '[':
+                        bracket = true;
+                        break;
+                    case '\\':
+                        escaped = true;
+                        break;
+                    case ';': // only positive section matters
+                        return false;
+                    case 'd':
+                    case 'D':
+                    case 'm':
+                    case 'M':
+                    case 'y':
+                    case 'Y':
+                    case 'h':
+                    case 'H':
+                    case 's':
+                    case 'S':
+                        return true;
+                    default:
+                        break;
+                }
+            }
+        }
+        return false;
+    }
+
+    date::year_month_day date_from_serial(double serial, bool date1904)
+    {
+        const auto days = static_cast<int>(serial);
+        if (date1904)
+            return date::year_month_day{date::sys_days{date::year{1904} / 1 / 1} + date::days{days}};
+        if (days == 60) // Lotus 1-2-3 leap year bug, xlnt returns 1900-02-29
+            return date::year{1900} / 2 / 29;
+        if (days < 60)
+            return date::year_month_day{date::sys_days{date::year{1899} / 12 / 31} + date::days{days}};
+        return date::year_month_day{date::sys_days{date::year{1899} / 12 / 30} + date::days{days}};
+    }
+
+} // namespace acmacs::xlsx::inline v1::stream
+
+// ----------------------------------------------------------------------
+
+namespace
+{
+    using namespace acmacs::xlsx::stream;
+
+    struct relationship_t
+    {
+        std::string type;
+        std::string target; // path inside zip
+    };
+
+    // dir is the directory of the part the rels belong to, e.g. "xl/"
+    inline std::unordered_map<std::string, relationship_t> read_relationships(const std::string& source, std::string_view dir)
+    {
+        std::unordered_map<std::string, relationship_t> result;
+        xml_scanner scanner{source};
+        for (auto token = scanner.next(); token != xml_scanner::token::eof; token = scanner.next()) {
+            if (token == xml_scanner::token::start && scanner.name() == "Relationship") {
+                std::string target;
+                xml_scanner::unescape(scanner.attribute("Target"), target);
+                if (!target.empty() && target[0] == '/')
+                    target.erase(0, 1);
+                else
+                    target.insert(0, dir);
+                result.emplace(std::string{scanner.attribute("Id")}, relationship_t{.type = std::string{scanner.attribute("Type")}, .target = std::move(target)});
+            }
+        }
+        return result;
+    }
+
+    inline std::string find_relationship_target(const std::unordered_map<std::string, relationship_t>& rels, std::string_view type_suffix, std::string_view dflt)
+    {
+        for (const auto& [id, rel] : rels) {
+            if (rel.type.ends_with(type_suffix))
+                return rel.target;
+        }
+        return std::string{dflt};
+    }
+
+    // "BC12" -> {row 11, col 54}
+    inline bool parse_cell_reference(std::string_view ref, size_t& row, size_t& col)
+    {
+        size_t pos{0}, column{0};
+        for (; pos < ref.size() && std::isalpha(static_cast<unsigned char>(ref[pos])); ++pos)
+            column = column * 26 + static_cast<size_t>(std::toupper(ref[pos]) - 'A' + 1);
+        size_t row_no{0};
+        if (column == 0 || std::from_chars(ref.data() + pos, ref.data() + ref.size(), row_no).ec != std::errc{} || row_no == 0)
+            return false;
+        row = row_no - 1;
+        col = column - 1;
+        return true;
+    }
+
+    template <typename Number> inline std::optional<Number> to_number(std::string_view src)
+    {
+        Number value{};
+        if (const auto [ptr, ec] = std::from_chars(src.data(), src.data() + src.size(), value); ec == std::errc{} && ptr == src.data() + src.size())
+            return value;
+        return std::nullopt;
+    }
+
+    // workbook part and relationships of the workbook part
+    struct workbook_location_t
+    {
+        std::string path;
+        std::string dir;
+        std::unordered_map<std::string, relationship_t> rels;
+    };
+
+    inline workbook_location_t locate_workbook(zip_archive& zip)
+    {
+        const auto package_rels = read_relationships(zip.read("_rels/.rels"), "");
+        workbook_location_t location{.path = find_relationship_target(package_rels, "/officeDocument", "xl/workbook.xml")};
+        location.dir = location.path.substr(0, location.path.rfind('/') + 1);
+        location.rels = read_relationships(zip.read(fmt::format("{}_rels/{}.rels", location.dir, location.path.substr(location.dir.size()))), location.dir);
+        return location;
+    }
+
+    // calls on_sheet(name, path) for each sheet of workbook.xml in workbook order, returns date1904 flag of the workbook
+    template <typename F> inline bool scan_workbook(zip_archive& zip, const workbook_location_t& location, F on_sheet)
+    {
+        const auto workbook = zip.read(location.path);
+        if (workbook.empty())
+            throw Error{fmt::format("no {} in xlsx", location.path)};
+        bool date1904{false};
+        xml_scanner scanner{workbook};
+        for (auto token = scanner.next(); token != xml_scanner::token::eof; token = scanner.next()) {
+            if (token != xml_scanner::token::start)
+                continue;
+            if (scanner.name() == "workbookPr") {
+                const auto flag = scanner.attribute("date1904");
+                date1904 = flag == "1" || flag == "true";
+            }
+            else if (scanner.name() == "sheet") {
+                std::string name;
+                xml_scanner::unescape(scanner.attribute("name"), name);
+                if (const auto rel = location.rels.find(std::string{scanner.attribute("id")}); rel != location.rels.end())
+                    on_sheet(std::move(name), rel->second.target);
+                else
+                    AD_WARNING("xlsx: no relationship for sheet \"{}\"", name);
+            }
+        }
+        return date1904;
+    }
+
+    // number of rows and columns from <dimension ref> of the sheet part,
+    // <dimension> precedes <sheetData>, only the beginning of the sheet part is inflated
+    inline std::optional<acmacs::sheet::cell_addr_t> read_dimension(zip_archive& zip, std::string_view path)
+    {
+        using namespace acmacs::sheet;
+
+        constexpr size_t header_size{8192};
+
+        auto header = zip.read(path, header_size);
+        header.resize(header.rfind('>') + 1); // drop truncated tag
+        xml_scanner scanner{header};
+        for (auto token = scanner.next(); token != xml_scanner::token::eof; token = scanner.next()) {
+            if (token != xml_scanner::token::start)
+                continue;
+            if (scanner.name() == "dimension") {
+                // "A1:K40" or "A1" if sheet is empty
+                auto ref = scanner.attribute("ref");
+                if (const auto colon = ref.find(':'); colon != std::string_view::npos)
+                    ref.remove_prefix(colon + 1);
+                if (size_t last_row{0}, last_col{0}; parse_cell_reference(ref, last_row, last_col))
+                    return cell_addr_t{nrow_t{last_row + 1}, ncol_t{last_col + 1}};
+                return std::nullopt;
+            }
+            if (scanner.name() == "sheetData")
+                break;
+        }
+        return std::nullopt;
+    }
+
+    // date-ness of cell styles, indexed by xf in cellXfs
+    inline std::vector<bool> read_date_styles_part(zip_archive& zip, std::string_view path)
+    {
+        const auto source = zip.read(path);
+        std::vector<bool> date_styles;
+        std::unordered_map<size_t, bool> custom_date_formats;
+        xml_scanner scanner{source};
+        bool in_cell_xfs{false};
+        for (auto token = scanner.next(); token != xml_scanner::token::eof; token = scanner.next()) {
+            if (token == xml_scanner::token::start) {
+                if (scanner.name() == "numFmt") {
+                    std::string code;
+                    xml_scanner::unescape(scanner.attribute("formatCode"), code);
+                    if (const auto id = to_number<size_t>(scanner.attribute("numFmtId")); id.has_value())
+                        custom_date_formats[*id] = is_date_format_code(code);
+                }
+                else if (scanner.name() == "cellXfs")
+                    in_cell_xfs = true;
+                else if (in_cell_xfs && scanner.name() == "xf") {
+                    const auto num_fmt_id = to_number<size_t>(scanner.attribute("numFmtId")).value_or(0);
+                    if (const auto custom = custom_date_formats.find(num_fmt_id); custom != custom_date_formats.end())
+                        date_styles.push_back(custom->second);
+                    else
+                        date_styles.push_back(is_builtin_date_format(num_fmt_id));
+                }
+            }
+            else if (token == xml_scanner::token::end && scanner.name() == "cellXfs")
+                in_cell_xfs = false;
+        }
+        return date_styles;
+    }
+
+} // namespace
+
+// ----------------------------------------------------------------------
+
+acmacs::xlsx::v1::stream::Doc::Doc(std::string_view filename)
+    : zip_{std::make_unique<zip_archive>(filename)}
+{
+    read_workbook();
+
+} // acmacs::xlsx::v1::stream::Doc::Doc
+
+// ----------------------------------------------------------------------
+
+acmacs::xlsx::v1::stream::Doc::~Doc() = default;
+
+// ----------------------------------------------------------------------
+
+void acmacs::xlsx::v1::stream::Doc::read_workbook()
+{
+    const auto location = locate_workbook(*zip_);
+    date1904_ = scan_workbook(*zip_, location, [this](std::string&& name, const std::string& path) { sheets_.push_back(sheet_entry_t{.name = std::move(name), .path = path}); });
+
+    read_shared_strings(find_relationship_target(location.rels, "/sharedStrings", fmt::format("{}sharedStrings.xml", location.dir)));
+    date_styles_ = read_date_styles_part(*zip_, find_relationship_target(location.rels, "/styles", fmt::format("{}styles.xml", location.dir)));
+
+} // acmacs::xlsx::v1::stream::Doc::read_workbook
+
+// ----------------------------------------------------------------------
+
+void acmacs::xlsx::v1::stream::Doc::read_shared_strings(std::string_view path)
+{
+    const auto source = zip_->read(path);
+    shared_strings_.reserve(source.size() / 2);
+    xml_scanner scanner{source};
+    size_t phonetic_depth{0}; // text inside <rPh> is ruby annotation, not a part of the value
+    bool in_text{false};
+    for (auto token = scanner.next(); token != xml_scanner::token::eof; token = scanner.next()) {
+        switch (token) {
+            case xml_scanner::token::start:
+                if (scanner.name() == "si")
+                    shared_string_at_.emplace_back(shared_strings_.size(), 0);
+                else if (scanner.name() == "rPh")
+                    ++phonetic_depth;
+                else if (scanner.name() == "t")
+                    in_text = phonetic_depth == 0;
+                break;
+            case xml_scanner::token::end:
+                if (scanner.name() == "si")
+                    shared_string_at_.back().second = shared_strings_.size() - shared_string_at_.back().first;
+                else if (scanner.name() == "rPh")
+                    --phonetic_depth;
+                else if (scanner.name() == "t")
+                    in_text = false;
+                break;
+            case xml_scanner::token::text:
+                if (in_text)
+                    xml_scanner::unescape(scanner.text(), shared_strings_);
+                break;
+            case xml_scanner::token::eof:
+                break;
+        }
+    }
+
+} // acmacs::xlsx::v1::stream::Doc::read_shared_strings
+
+// ----------------------------------------------------------------------
+
+std::vector<bool> acmacs::xlsx::v1::stream::read_date_styles(std::string_view filename)
+{
+    zip_archive zip{filename};
+    const auto location = locate_workbook(zip);
+    return read_date_styles_part(zip, find_relationship_target(location.rels, "/styles", fmt::format("{}styles.xml", location.dir)));
+
+} // acmacs::xlsx::v1::stream::read_date_styles
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::sheet::sheet_info_t> acmacs::xlsx::v1::stream::read_sheet_info(std::string_view filename)
+{
+    zip_archive zip{filename};
+    std::vector<acmacs::sheet::sheet_info_t> info;
+    scan_workbook(zip, locate_workbook(zip), [&zip, &info](std::string&& name, const std::string& path) { info.push_back({.name = std::move(name), .dimension = read_dimension(zip, path)}); });
+    return info;
+
+} // acmacs::xlsx::v1::stream::read_sheet_info
+
+// ----------------------------------------------------------------------
+
+acmacs::sheet::sheet_info_t acmacs::xlsx::v1::stream::Doc::sheet_info(size_t sheet_no)
+{
+    const auto& entry = sheets_.at(sheet_no);
+    return {.name = entry.name, .dimension = read_dimension(*zip_, entry.path)};
+
+} // acmacs::xlsx::v1::stream::Doc::sheet_info
+
+// ----------------------------------------------------------------------
+
+std::shared_ptr<acmacs::sheet::Sheet> acmacs::xlsx::v1::stream::Doc::sheet(size_t sheet_no)
+{
+    using namespace acmacs::sheet;
+
+    const auto& entry = sheets_.at(sheet_no);
+    const auto source = zip_->read(entry.path);
+
+    enum class value_type { number, shared_string, string, inline_string, boolean, error, date };
+    struct raw_cell_t
+    {
+        size_t row;
+        size_t col;
+        value_type type;
+        size_t style;
+        std::string_view value; // raw text inside <v>, or unescaped text of the inline string (in inline_strings)
+    };
+
+    std::vector<raw_cell_t> cells;
+    std::deque<std::string> inline_strings; // deque: stable references
+    std::string unescaped;
+
+    xml_scanner scanner{source};
+    size_t current_row{0}, next_row{0}, next_col{0};
+    std::optional<raw_cell_t> cell;
+    enum class collect { none, value, inline_text } collecting{collect::none};
+    for (auto token = scanner.next(); token != xml_scanner::token::eof; token = scanner.next()) {
+        switch (token) {
+            case xml_scanner::token::start:
+                if (scanner.name() == "row") {
+                    if (const auto row_no = to_number<size_t>(scanner.attribute("r")); row_no.has_value() && *row_no > 0)
+                        current_row = *row_no - 1;
+                    else
+                        current_row = next_row;
+                    next_row = current_row + 1;
+                    next_col = 0;
+                }
+                else if (scanner.name() == "c") {
+                    cell = raw_cell_t{.row = current_row, .col = next_col, .type = value_type::number, .style = to_number<size_t>(scanner.attribute("s")).value_or(0), .value = {}};
+                    unescaped.clear();
+                    if (const auto ref = scanner.attribute("r"); !ref.empty())
+                        parse_cell_reference(ref, cell->row, cell->col);
+                    next_col = cell->col + 1;
+                    if (const auto type = scanner.attribute("t"); type == "s")
+                        cell->type = value_type::shared_string;
+                    else if (type == "str")
+                        cell->type = value_type::string;
+                    else if (type == "inlineStr")
+                        cell->type = value_type::inline_string;
+                    else if (type == "b")
+                        cell->type = value_type::boolean;
+                    else if (type == "e")
+                        cell->type = value_type::error;
+                    else if (type == "d")
+                        cell->type = value_type::date;
+                }
+                else if (cell.has_value() && scanner.name() == "v")
+                    collecting = collect::value;
+                else if (cell.has_value() && scanner.name() == "t" && cell->type == value_type::inline_string)
+                    collecting = collect::inline_text; // rich text inline string has several <t> elements
+                break;
+            case xml_scanner::token::text:
+                if (collecting == collect::value)
+                    cell->value = scanner.text();
+                else if (collecting == collect::inline_text)
+                    xml_scanner::unescape(scanner.text(), unescaped);
+                break;
+            case xml_scanner::token::end:
+                if (scanner.name() == "c" && cell.has_value()) {
+                    if (cell->type == value_type::inline_string)
+                        cell->value = inline_strings.emplace_back(unescaped);
+                    if (!cell->value.empty())
+                        cells.push_back(*cell);
+                    cell.reset();
+                }
+                else if (scanner.name() == "v" || scanner.name() == "t")
+                    collecting = collect::none;
+                break;
+            case xml_scanner::token::eof:
+                break;
+        }
+    }
+
+    const auto string_value = [this, &unescaped](const raw_cell_t& raw) -> std::string_view {
+        switch (raw.type) {
+            case value_type::shared_string:
+                if (const auto index = to_number<size_t>(raw.value); index.has_value() && *index < shared_string_at_.size())
+                    return std::string_view{shared_strings_}.substr(shared_string_at_[*index].first, shared_string_at_[*index].second);
+                return {};
+            case value_type::string:
+                unescaped.clear();
+                xml_scanner::unescape(raw.value, unescaped);
+                return unescaped;
+            case value_type::inline_string:
+                return raw.value;
+            case value_type::number:
+            case value_type::boolean:
+            case value_type::error:
+            case value_type::date:
+                break;
+        }
+        return {};
+    };
+
+    const auto is_string = [](const raw_cell_t& raw) { return raw.type == value_type::shared_string || raw.type == value_type::string || raw.type == value_type::inline_string; };
+
+    // used range: empty strings do not count, trailing empty rows and columns are not included
+    size_t number_of_rows{0}, number_of_columns{0};
+    for (const auto& raw : cells) {
+        if (!is_string(raw) || !string_value(raw).empty()) {
+            number_of_rows = std::max(number_of_rows, raw.row + 1);
+            number_of_columns = std::max(number_of_columns, raw.col + 1);
+        }
+    }
+
+    cell_grid_t grid{nrow_t{number_of_rows}, ncol_t{number_of_columns}};
+    for (const auto& raw : cells) {
+        if (raw.row >= number_of_rows || raw.col >= number_of_columns)
+            continue;
+        const nrow_t row{raw.row};
+        const ncol_t col{raw.col};
+        switch (raw.type) {
+            case value_type::shared_string:
+            case value_type::string:
+            case value_type::inline_string:
+                if (const auto text = string_value(raw); !text.empty())
+                    grid.set_string(row, col, text);
+                break;
+            case value_type::boolean:
+                grid.set(row, col, raw.value == "1" || raw.value == "true");
+                break;
+            case value_type::error:
+                grid.set(row, col, cell::error{});
+                break;
+            case value_type::date:
+                grid.set(row, col, date::from_string(raw.value.substr(0, 10), date::allow_incomplete::no, date::throw_on_error::no));
+                break;
+            case value_type::number:
+                if (const auto value = to_number<double>(raw.value); value.has_value()) {
+                    if (raw.style < date_styles_.size() && date_styles_[raw.style])
+                        grid.set(row, col, date_from_serial(*value, date1904_));
+                    else if (!float_equal(*value, std::round(*value)))
+                        grid.set(row, col, *value);
+                    else
+                        grid.set(row, col, static_cast<long>(std::llround(*value)));
+                }
+                else
+                    grid.set(row, col, cell::error{});
+                break;
+        }
+    }
+
+    return std::make_shared<GridSheet>(entry.name, std::move(grid));
+
+} // acmacs::xlsx::v1::stream::Doc::sheet
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+
+#include "acmacs-whocc/sheet-grid.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::xlsx::inline v1
+{
+    namespace stream
+    {
+        class zip_archive;
+
+        // date/time number formats are recognized the way xlnt does it
+        bool is_date_format_code(std::string_view code);
+        constexpr bool is_builtin_date_format(size_t id) { return (id >= 14 && id <= 22) || (id >= 45 && id <= 47); }
+        date::year_month_day date_from_serial(double serial, bool date1904);
+
+        // date-ness of cell styles (index in cellXfs of styles.xml) of xlsx, for the backends that resolve number formats per cell
+        std::vector<bool> read_date_styles(std::string_view filename);
+
+        // names and <dimension> of sheets in workbook order, for the backends that know dimension only after reading cells
+        std::vector<acmacs::sheet::sheet_info_t> read_sheet_info(std::string_view filename);
+        // looked up by name, the backends do not necessarily count chartsheets
+        inline acmacs::sheet::sheet_info_t find_sheet_info(const std::vector<acmacs::sheet::sheet_info_t>& info, std::string_view name)
+        {
+            if (const auto found = std::find_if(std::begin(info), std::end(info), [name](const auto& en) { return en.name == name; }); found != std::end(info))
+                return *found;
+            return {.name = std::string{name}};
+        }
+
+        // Values only xlsx reader: sheetN.xml and sharedStrings.xml are
+        // inflated out of the zip on demand and scanned without building
+        // a DOM, styles.xml is consulted once to find date formats.
+        // sheet() and sheet_info() may be called concurrently.
+        class Doc
+        {
+          public:
+            static constexpr uint32_t reader_version{1}; // bump when cells produced by the reader change, it is part of the snapshot key
+
+            Doc(std::string_view filename);
+            ~Doc();
+
+            size_t number_of_sheets() const { return sheets_.size(); }
+            acmacs::sheet::sheet_info_t sheet_info(size_t sheet_no); // without reading cells
+            std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no);
+
+          private:
+            struct sheet_entry_t
+            {
+                std::string name;
+                std::string path; // inside zip
+            };
+
+            std::unique_ptr<zip_archive> zip_;
+            std::vector<sheet_entry_t> sheets_;
+            std::string shared_strings_;                             // all shared strings, concatenated
+            std::vector<std::pair<size_t, size_t>> shared_string_at_; // offset and size in shared_strings_
+            std::vector<bool> date_styles_;                          // indexed by cell style id (s attribute)
+            bool date1904_{false};
+
+            void read_workbook();
+            void read_shared_strings(std::string_view path);
+        };
+
+    } // namespace stream
+
+} // namespace acmacs::xlsx::inline v1
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -2,54 +2,65 @@
 
 #include "acmacs-base/float.hh"
 #include "acmacs-base/xlnt.hh"
-#include "acmacs-whocc/sheet.hh"
+#include "acmacs-whocc/sheet-grid.hh"
+#include "acmacs-whocc/xlsx-stream.hh"
 
 // ----------------------------------------------------------------------
 
 namespace acmacs::xlsx::inline v1
 {
+    using acmacs::sheet::materialize;
+
     namespace xlnt
     {
         class Doc;
 
+        // date-ness of numeric cells by cell style (format id, i.e. xf index in cellXfs), styles.xml is read once when the workbook is opened,
+        // as in the stream backend; xlnt resolves number format of the cell on each cell.is_date() call and throws on unsupported formats
+        class date_styles_t
+        {
+          public:
+            date_styles_t(std::string_view filename) : styles_{stream::read_date_styles(filename)} {}
+
+            bool is_date(const ::xlnt::cell& cell) const
+            {
+                if (!cell.has_format())
+                    return false;
+                const auto style = cell.format().id();
+                return style < styles_.size() && styles_[style];
+            }
+
+          private:
+            const std::vector<bool> styles_; // indexed by format id
+        };
+
         class Sheet : public acmacs::sheet::Sheet
         {
           public:
-            Sheet(::xlnt::worksheet&& src) : sheet_{std::move(src)}, number_of_rows_{sheet_.highest_row()}, number_of_columns_{sheet_.highest_column().index}
+            Sheet(::xlnt::worksheet&& src, const date_styles_t& date_styles) : sheet_{std::move(src)}, date_styles_{date_styles}
             {
-                using namespace acmacs::sheet;
-
-                if (number_of_columns_ > ncol_t{0} && number_of_rows_ > nrow_t{0}) {
-                    // remove last empty columns
-                    const auto is_empty_col = [this](ncol_t col) {
-                        for (nrow_t row{0}; row < number_of_rows_; ++row) {
-                            if (!is_empty(cell(row, col)))
-                                return false;
-                        }
-                        return true;
-                    };
-
-                    for (ncol_t col{number_of_columns_ - ncol_t{1}}; col > ncol_t{0}; --col) {
-                        if (!is_empty_col(col))
-                            break;
-                        --number_of_columns_;
-                    }
+                // used range in one pass over the stored cells, trailing empty rows and columns are not included
+                for_each_cell(sheet_, date_styles_, [this](sheet::nrow_t row, sheet::ncol_t col, acmacs::sheet::cell_t&&) {
+                    number_of_rows_ = std::max(number_of_rows_, row + sheet::nrow_t{1});
+                    number_of_columns_ = std::max(number_of_columns_, col + sheet::ncol_t{1});
+                });
+            }
 
-                    // remove last empty rows
-                    const auto is_empty_row = [this](nrow_t row) {
-                        for (ncol_t col{0}; col < number_of_columns_; ++col) {
-                            if (!is_empty(cell(row, col)))
-                                return false;
-                        }
-                        return true;
-                    };
-
-                    for (nrow_t row{number_of_rows_ - nrow_t{1}}; row > nrow_t{0}; --row) {
-                        if (!is_empty_row(row))
-                            break;
-                        --number_of_rows_;
-                    }
-                }
+            // reads stored cells once, builds grid of the used range
+            static std::shared_ptr<acmacs::sheet::GridSheet> materialize(const ::xlnt::worksheet& src, const date_styles_t& date_styles)
+            {
+                std::vector<std::tuple<sheet::nrow_t, sheet::ncol_t, acmacs::sheet::cell_t>> cells;
+                sheet::nrow_t number_of_rows{0};
+                sheet::ncol_t number_of_columns{0};
+                for_each_cell(src, date_styles, [&](sheet::nrow_t row, sheet::ncol_t col, acmacs::sheet::cell_t&& cell) {
+                    number_of_rows = std::max(number_of_rows, row + sheet::nrow_t{1});
+                    number_of_columns = std::max(number_of_columns, col + sheet::ncol_t{1});
+                    cells.emplace_back(row, col, std::move(cell));
+                });
+                acmacs::sheet::cell_grid_t grid{number_of_rows, number_of_columns};
+                for (const auto& [row, col, cell] : cells)
+                    grid.set(row, col, cell);
+                return std::make_shared<acmacs::sheet::GridSheet>(src.title(), std::move(grid));
             }
 
             std::string name() const override { return sheet_.title(); }
@@ -63,23 +74,16 @@ namespace acmacs::xlsx::inline v1
                 return date::year{dt.year} / date::month{static_cast<unsigned>(dt.month)} / dt.day;
             }
 
-            static inline bool is_date(const ::xlnt::cell& cell)
-            {
-                try {
-                    return cell.is_date();
-                }
-                catch (...) {
-                    return false; // xlnt throws when xlsx format is unsupported in some aspect
-                }
-            }
-
             acmacs::sheet::cell_t cell(sheet::nrow_t row, sheet::ncol_t col) const override // row and col are zero based
             {
                 const ::xlnt::cell_reference ref{static_cast<::xlnt::column_t::index_t>(*col + 1), static_cast<::xlnt::row_t>(*row + 1)};
                 if (!sheet_.has_cell(ref))
                     return acmacs::sheet::cell::empty{};
+                return make_cell(sheet_.cell(ref), date_styles_, row, col);
+            }
 
-                const auto cell = sheet_.cell(ref);
+            static acmacs::sheet::cell_t make_cell(const ::xlnt::cell& cell, const date_styles_t& date_styles, sheet::nrow_t row, sheet::ncol_t col)
+            {
                 switch (cell.data_type()) { // ~/AD/build/acmacs-build/build/xlnt/include/xlnt/cell/cell_type.hpp
                     case ::xlnt::cell_type::empty:
                         return acmacs::sheet::cell::empty{};
@@ -93,7 +97,7 @@ namespace acmacs::xlsx::inline v1
                         else
                             return acmacs::sheet::cell::empty{};
                     case ::xlnt::cell_type::number:
-                        if (is_date(cell))
+                        if (date_styles.is_date(cell))
                             return make_date(cell.value<::xlnt::datetime>(), row, col);
                         else if (const auto vald = cell.value<double>(); !float_equal(vald, std::round(vald)))
                             return vald;
@@ -148,20 +152,48 @@ namespace acmacs::xlsx::inline v1
 
           private:
             ::xlnt::worksheet sheet_;
-            sheet::nrow_t number_of_rows_;
-            sheet::ncol_t number_of_columns_;
+            const date_styles_t& date_styles_;
+            sheet::nrow_t number_of_rows_{0};
+            sheet::ncol_t number_of_columns_{0};
+
+            // calls func(row, col, cell) for each stored non-empty cell, row and col are zero based
+            template <typename F> static void for_each_cell(const ::xlnt::worksheet& src, const date_styles_t& date_styles, F func)
+            {
+                for (const auto& cells : src.rows(true)) { // skip_null: cells not stored in the xlsx are not visited
+                    for (const auto& stored : cells) {
+                        const auto ref = stored.reference();
+                        const sheet::nrow_t row{ref.row() - 1};
+                        const sheet::ncol_t col{ref.column().index - 1};
+                        if (auto cell = make_cell(stored, date_styles, row, col); !acmacs::sheet::is_empty(cell))
+                            func(row, col, std::move(cell));
+                    }
+                }
+            }
         };
 
         class Doc
         {
           public:
-            Doc(std::string_view filename) : workbook_{::xlnt::path{std::string{filename}}} {}
+            static constexpr uint32_t reader_version{1}; // bump when cells produced by the reader change, it is part of the snapshot key
+
+            Doc(std::string_view filename, materialize mat = materialize::yes) : workbook_{::xlnt::path{std::string{filename}}}, materialize_{mat}, date_styles_{filename}, sheet_info_{stream::read_sheet_info(filename)} {}
 
             size_t number_of_sheets() const { return workbook_.sheet_count(); }
-            std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no) { return std::make_shared<Sheet>(workbook_.sheet_by_index(sheet_no)); }
+            acmacs::sheet::sheet_info_t sheet_info(size_t sheet_no) const { return stream::find_sheet_info(sheet_info_, workbook_.sheet_titles().at(sheet_no)); }
+
+            std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no)
+            {
+                if (materialize_ == materialize::yes)
+                    return Sheet::materialize(workbook_.sheet_by_index(sheet_no), date_styles_);
+                else
+                    return std::make_shared<Sheet>(workbook_.sheet_by_index(sheet_no), date_styles_);
+            }
 
           private:
             ::xlnt::workbook workbook_;
+            const materialize materialize_;
+            const date_styles_t date_styles_;
+            const std::vector<acmacs::sheet::sheet_info_t> sheet_info_; // xlnt knows dimension only after loading cells, it is read from <dimension> of sheet parts
         };
 
     } // namespace xlnt
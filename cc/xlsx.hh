@@ -2,10 +2,20 @@
 
 #include <variant>
 #include <memory>
+#include <cstdlib>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <numeric>
+#include <optional>
 
 #include "acmacs-base/string-compare.hh"
+#include "acmacs-whocc/log.hh"
 #include "acmacs-whocc/xlsx-xlnt.hh"
+#include "acmacs-whocc/xlsx-stream.hh"
+#include "acmacs-whocc/xlsx-openxlsx.hh"
 #include "acmacs-whocc/csv-parser.hh"
+#include "acmacs-whocc/xlsx-snapshot.hh"
 
 // ----------------------------------------------------------------------
 
@@ -24,38 +34,226 @@ namespace acmacs::xlsx::inline v1
 
     // ----------------------------------------------------------------------
 
+    enum class backend { stream, xlnt, openxlsx };
+
+    inline backend backend_from_name(std::string_view name)
+    {
+        if (name.empty() || name == "stream")
+            return backend::stream;
+        if (name == "xlnt")
+            return backend::xlnt;
+        if (name == "openxlsx")
+            return backend::openxlsx;
+        throw Error{fmt::format("unsupported xlsx backend \"{}\" (stream, xlnt, openxlsx supported)", name)};
+    }
+
+    inline std::string_view backend_name(backend bk)
+    {
+        switch (bk) {
+            case backend::stream:
+                return "stream";
+            case backend::xlnt:
+                return "xlnt";
+            case backend::openxlsx:
+                return "openxlsx";
+        }
+        return "stream";
+    }
+
+    inline uint32_t reader_version(backend bk)
+    {
+        switch (bk) {
+            case backend::stream:
+                return stream::Doc::reader_version;
+            case backend::xlnt:
+                return xlnt::Doc::reader_version;
+            case backend::openxlsx:
+                return openxlsx::Doc::reader_version;
+        }
+        return stream::Doc::reader_version;
+    }
+
+    // ACMACS_XLSX_BACKEND=stream|xlnt|openxlsx selects xlsx reader, values only stream reader is used by default
+    inline backend backend_from_environment()
+    {
+        if (const char* env = std::getenv("ACMACS_XLSX_BACKEND"); env)
+            return backend_from_name(env);
+        return backend::stream;
+    }
+
+    // ----------------------------------------------------------------------
+
     class Doc
     {
       public:
+        // snapshot with sheets read by sheet() after the last read_sheets() is written here
+        ~Doc()
+            {
+                if (snapshot_outdated_) {
+                    try {
+                        write_snapshot();
+                    }
+                    catch (std::exception& err) {
+                        AD_WARNING("cannot write sheet snapshot {}: {}", snapshot_filename_, err.what());
+                    }
+                }
+            }
+
         size_t number_of_sheets() const
             {
                 return std::visit([](const auto& ptr) { return ptr->number_of_sheets(); }, doc_);
             }
 
-        std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no) {
-            return std::visit([sheet_no](const auto& ptr) { return ptr->sheet(sheet_no); }, doc_);
-        }
+        // name and dimension, sheets to be ignored can be rejected without reading their cells
+        // sheet part header is inflated once, snapshot writing reuses the info
+        acmacs::sheet::sheet_info_t sheet_info(size_t sheet_no)
+            {
+                if (!info_.at(sheet_no))
+                    info_[sheet_no] = std::visit([sheet_no](const auto& ptr) { return ptr->sheet_info(sheet_no); }, doc_);
+                return *info_[sheet_no];
+            }
+
+        // sheet is read on the first request and kept by the document, snapshot is not rewritten for every such sheet
+        std::shared_ptr<acmacs::sheet::Sheet> sheet(size_t sheet_no)
+            {
+                if (!sheets_.at(sheet_no))
+                    read_missing_sheets({sheet_no}, 1);
+                return sheets_[sheet_no];
+            }
+
+        // reads sheets into the document, subsequent sheet() calls return them
+        // stream backend reads sheets concurrently (inflate and xml scan per sheet), number_of_threads 0: hardware concurrency
+        // xlnt and OpenXLSX documents are not thread safe, their sheets are read one by one
+        // if snapshots are enabled, the snapshot is (re)written with the sheets read so far
+        void read_sheets(const std::vector<size_t>& sheet_nos, size_t number_of_threads = 0)
+            {
+                read_missing_sheets(sheet_nos, number_of_threads);
+                if (snapshot_outdated_)
+                    write_snapshot();
+            }
+
+        void read_sheets(size_t number_of_threads = 0)
+            {
+                std::vector<size_t> sheet_nos(number_of_sheets());
+                std::iota(std::begin(sheet_nos), std::end(sheet_nos), 0ul);
+                read_sheets(sheet_nos, number_of_threads);
+            }
 
       protected:
-        Doc(std::string_view filename)
+        Doc(std::string_view filename, backend bk, materialize mat) : filename_{filename}, backend_{bk}, materialize_{mat}
         {
-            if (acmacs::string::endswith_ignore_case(filename, ".csv"))
-                doc_ = std::make_unique<csv::Doc>(filename);
-            else if (acmacs::string::endswith_ignore_case(filename, ".xlsx"))
-                doc_ = std::make_unique<XlDoc>(filename);
-            else
-                throw Error{fmt::format("unsupported suffix in {}", filename)};
+            // materialized sheets of xlsx are kept in snapshot if ACMACS_XLSX_SNAPSHOT_DIR is set
+            // snapshot is written by read_sheets() and on destruction, i.e. only sheets requested by the caller are read
+            if (mat == materialize::yes && acmacs::string::endswith_ignore_case(filename, ".xlsx")) {
+                if (const auto snapshot_dir = snapshot::directory_from_environment(); !snapshot_dir.empty()) {
+                    snapshot_filename_ = snapshot::filename(snapshot_dir, filename, backend_name(bk), reader_version(bk));
+                    if (auto snapshot_doc = snapshot::Doc::load(snapshot_filename_); snapshot_doc) {
+                        doc_ = std::move(snapshot_doc);
+                        sheets_.resize(number_of_sheets());
+                        info_.resize(sheets_.size());
+                        return;
+                    }
+                }
+            }
+
+            open_backend();
+            sheets_.resize(number_of_sheets());
+            info_.resize(sheets_.size());
         }
 
       private:
-        std::variant<std::unique_ptr<XlDoc>, std::unique_ptr<csv::Doc>> doc_;
+        std::variant<std::unique_ptr<XlDoc>, std::unique_ptr<stream::Doc>, std::unique_ptr<openxlsx::Doc>, std::unique_ptr<csv::Doc>, std::unique_ptr<snapshot::Doc>> doc_;
+        std::vector<std::shared_ptr<acmacs::sheet::Sheet>> sheets_;
+        std::vector<std::optional<acmacs::sheet::sheet_info_t>> info_;
+        std::string filename_;
+        backend backend_;
+        materialize materialize_;
+        std::string snapshot_filename_; // empty if snapshots are not used
+        bool snapshot_outdated_{false};  // sheets were read by the backend after the snapshot was written
+
+        void open_backend()
+            {
+                if (acmacs::string::endswith_ignore_case(filename_, ".csv") || acmacs::string::endswith_ignore_case(filename_, ".tsv"))
+                    doc_ = std::make_unique<csv::Doc>(filename_);
+                else if (acmacs::string::endswith_ignore_case(filename_, ".xlsx")) {
+                    switch (backend_) {
+                        case backend::stream:
+                            doc_ = std::make_unique<stream::Doc>(filename_);
+                            break;
+                        case backend::xlnt:
+                            doc_ = std::make_unique<XlDoc>(filename_, materialize_);
+                            break;
+                        case backend::openxlsx:
+                            doc_ = std::make_unique<openxlsx::Doc>(filename_, materialize_);
+                            break;
+                    }
+                }
+                else
+                    throw Error{fmt::format("unsupported suffix in {}", filename_)};
+            }
+
+        std::shared_ptr<acmacs::sheet::Sheet> read_sheet(size_t sheet_no)
+            {
+                return std::visit([sheet_no](const auto& ptr) { return ptr->sheet(sheet_no); }, doc_);
+            }
+
+        // snapshot_outdated_ is set if sheets were read by the backend, the caller writes the snapshot
+        void read_missing_sheets(const std::vector<size_t>& sheet_nos, size_t number_of_threads)
+            {
+                std::vector<size_t> to_read;
+                std::copy_if(std::begin(sheet_nos), std::end(sheet_nos), std::back_inserter(to_read), [this](size_t sheet_no) { return !sheets_.at(sheet_no); });
+                if (to_read.empty())
+                    return;
+                if (const auto* snapshot_doc = std::get_if<std::unique_ptr<snapshot::Doc>>(&doc_);
+                    snapshot_doc && std::any_of(std::begin(to_read), std::end(to_read), [snapshot_doc](size_t sheet_no) { return !(*snapshot_doc)->has_sheet(sheet_no); })) {
+                    // snapshot has no cells of some requested sheets: sheets of the snapshot are kept, others are read by the backend
+                    for (size_t sheet_no = 0; sheet_no < sheets_.size(); ++sheet_no) {
+                        if (!sheets_[sheet_no])
+                            sheets_[sheet_no] = (*snapshot_doc)->sheet(sheet_no);
+                    }
+                    open_backend();
+                    to_read.erase(std::remove_if(std::begin(to_read), std::end(to_read), [this](size_t sheet_no) { return sheets_[sheet_no] != nullptr; }), std::end(to_read));
+                }
+                const bool from_snapshot = std::holds_alternative<std::unique_ptr<snapshot::Doc>>(doc_);
+                if (!std::holds_alternative<std::unique_ptr<stream::Doc>>(doc_))
+                    number_of_threads = 1;
+                else if (number_of_threads == 0)
+                    number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+                number_of_threads = std::min(number_of_threads, to_read.size());
+
+                std::atomic<size_t> next{0};
+                const auto worker = [this, &to_read, &next]() {
+                    for (auto index = next++; index < to_read.size(); index = next++)
+                        sheets_[to_read[index]] = read_sheet(to_read[index]);
+                };
+                std::vector<std::future<void>> workers;
+                for (size_t thread_no = 1; thread_no < number_of_threads; ++thread_no)
+                    workers.push_back(std::async(std::launch::async, worker));
+                if (number_of_threads > 0)
+                    worker();
+                for (auto& result : workers)
+                    result.get(); // rethrows exception of the worker
+
+                if (!snapshot_filename_.empty() && !from_snapshot)
+                    snapshot_outdated_ = true;
+            }
+
+        // sheets not read (ignored by the caller) are stored with their name and dimension only
+        void write_snapshot()
+            {
+                std::vector<acmacs::sheet::sheet_info_t> info(sheets_.size());
+                for (size_t sheet_no = 0; sheet_no < sheets_.size(); ++sheet_no)
+                    info[sheet_no] = sheet_info(sheet_no);
+                snapshot::write(snapshot_filename_, sheets_, info);
+                snapshot_outdated_ = false;
+            }
 
-        friend Doc open(std::string_view filename);
+        friend Doc open(std::string_view filename, backend bk, materialize mat);
     };
 
     // ----------------------------------------------------------------------
 
-    inline Doc open(std::string_view filename) { return filename; }
+    inline Doc open(std::string_view filename, backend bk = backend_from_environment(), materialize mat = materialize::yes) { return Doc{filename, bk, mat}; }
 
 } // namespace acmacs::xlsx::inline v1
 
@@ -26,6 +26,7 @@ int main(int argc, char* const argv[])
 
         CsvWriter csv;
         auto doc = acmacs::xlsx::open(opt.xlsx);
+        doc.read_sheets();
         for (const auto sheet_no : range_from_0_to(doc.number_of_sheets())) {
             if (sheet_no)
                 csv << CsvWriter::end_of_row << CsvWriter::end_of_row;
@@ -37,8 +38,8 @@ int main(int argc, char* const argv[])
             csv << CsvWriter::end_of_row;
             for (acmacs::sheet::nrow_t row{0}; row < sheet->number_of_rows(); ++row) {
                 csv << *row + 1;
-                for (acmacs::sheet::ncol_t col{0}; col < sheet->number_of_columns(); ++col)
-                    csv << fmt::format("{}", sheet->cell(row, col));
+                for (const auto cell : sheet->row(row))
+                    csv << fmt::format("{}", cell);
                 csv << CsvWriter::end_of_row;
             }
         }
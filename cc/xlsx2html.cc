@@ -52,6 +52,7 @@ int main(int argc, char* const argv[])
         };
 
         auto doc = acmacs::xlsx::open(opt.xlsx);
+        doc.read_sheets();
         for (const auto sheet_no : range_from_0_to(doc.number_of_sheets())) {
             if (sheet_no)
                 fmt::format_to_mb(out, "<br><br><br><hr><br><br><br>\n");
@@ -63,8 +64,9 @@ int main(int argc, char* const argv[])
                 fmt::format_to_mb(out, "<tr><td class='col-row-no'>{}</td>", row);
                 std::string prev_cell;
                 size_t colspan = 0;
+                const auto cells = sheet->row(row);
                 for (acmacs::sheet::ncol_t col{0}; col < sheet->number_of_columns(); ++col) {
-                    auto cell = fmt::format("{}", sheet->cell(row, col));
+                    auto cell = fmt::format("{}", cells[col]);
                     // if (const auto cell_spans = sheet->cell_spans(row, col); !cell_spans.empty()) {
                     //     cell = fmt::format("<span style='color: {}; background: {}'>{}</span>", cell_spans[0].foreground, cell_spans[0].background, cell);
                     // }